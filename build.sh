@@ -57,7 +57,7 @@ srcdir=js
 builddir=build
 tooldir=tools
 textdir=texts
-data=game/src/data/data.bin
+data=game/src/data/data.o
 dataname=ph_data
 
 debug=false
@@ -0,0 +1,1038 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include <getopt.h>
+
+#include <gen.h>
+#include <stats.h>
+
+#include <bytecode.h>
+#include <conv.h>
+#include <input.h>
+#include <link.h>
+#include <object.h>
+#include <scan.h>
+
+#include <commands.h>
+#include <format.h>
+
+static const char help_str[] =
+    "USAGE: %s [-hgm] [-n RUNS] [-s SIZE] [-L LABELS] [-P PROSE]\n"
+    "       [-C CASES] [-D DENSITY] [-V VERBATIM] [INPUT_FILES...]\n"
+    "Phosphor Engine datagen benchmarks\n"
+    "\n"
+    "The input files are repeated until the benchmark input is at least SIZE\n"
+    "MiB large. With -g, a synthetic source is converted and linked instead.\n"
+    "\n"
+    "Options:\n"
+    "  -n   Number of runs of each benchmark, the fastest one is kept\n"
+    "  -s   Size of the benchmark input in MiB\n"
+    "  -h   Show this help message\n";
+
+static const char gen_help_str[] =
+    "  -g   Benchmark a synthetic source\n"
+    "  -m   Print key=value lines, to compare the results of several commits\n"
+    "  -L   Number of labels of the synthetic source\n"
+    "  -P   KiB of prose of the synthetic source\n"
+    "  -C   Cases per ask in the synthetic source\n"
+    "  -D   Percentage of the lines of prose preceded by a command\n"
+    "  -V   Number of verbatim blocks of the synthetic source\n";
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+static void report(char *name, size_t size, double time) {
+    printf("%-12s %10.2f MiB/s %10.3f ms\n", name,
+           size/(1024.0*1024.0)/time, time*1000);
+}
+
+/* Input paths compared by the conversion benchmark */
+enum {
+    PH_BENCH_INPUT_MMAP,
+    PH_BENCH_INPUT_BLOCK,
+    PH_BENCH_INPUT_BYTE,
+    PH_BENCH_INPUT_SCALAR,
+
+    PH_BENCH_INPUT_AMOUNT
+};
+
+static int convert(FILE *in, int mode, double *time) {
+    PHConv conv;
+    PHInput input;
+    PHBuffer buffer;
+    unsigned char r;
+    double start;
+    int rc = 0;
+
+    rewind(in);
+
+    if(ph_conv_init(&conv, &ph_commands, NULL)) return 1;
+
+    start = now();
+
+    switch(mode){
+        case PH_BENCH_INPUT_MMAP:
+            rc = ph_conv_convert(&conv, in) != PH_CONV_SUCCESS;
+            break;
+
+        case PH_BENCH_INPUT_BLOCK:
+            if(ph_input_read(&input, in)){
+                rc = 1;
+                break;
+            }
+            rc = ph_conv_convert_mem(&conv, input.data, input.size) !=
+                 PH_CONV_SUCCESS;
+            ph_input_close(&input);
+            break;
+
+        case PH_BENCH_INPUT_SCALAR:
+            /* Block reads without the bulk copy of plain chars */
+            conv.bulk = 0;
+            if(ph_input_read(&input, in)){
+                rc = 1;
+                break;
+            }
+            rc = ph_conv_convert_mem(&conv, input.data, input.size) !=
+                 PH_CONV_SUCCESS;
+            ph_input_close(&input);
+            break;
+
+        case PH_BENCH_INPUT_BYTE:
+            /* The way ph_conv_convert used to read its input */
+            if(ph_buffer_init(&buffer, 64)){
+                rc = 1;
+                break;
+            }
+            while(fread(&r, 1, 1, in) == 1){
+                ph_buffer_putc(&buffer, r);
+            }
+            rc = ph_conv_convert_mem(&conv, buffer.data, buffer.size) !=
+                 PH_CONV_SUCCESS;
+            ph_buffer_free(&buffer);
+            break;
+    }
+
+    *time = now()-start;
+
+    if(rc){
+        fprintf(stderr, "Conversion failed: %s\n", ph_conv_get_error(&conv));
+    }
+
+    ph_conv_free(&conv);
+
+    return rc;
+}
+
+/* Command heavy script used to benchmark the command dispatch */
+static const char cmd_script[] =
+    "#var set hp 100\n"
+    "#var load hp\n"
+    "#tmp push\n"
+    "#math sub\n"
+    "#branch le dead\n"
+    "#note C-4 100\n"
+    "#note A-3 50\n"
+    "#io putint\n"
+    "#delay 10\n";
+
+#define PH_BENCH_CMD_SCRIPT_CMDS 9
+
+static int bench_cmds(size_t size, size_t runs) {
+    PHBuffer script;
+    PHConv conv;
+    double best = 0;
+    size_t copies = 0;
+    size_t i;
+
+    if(ph_buffer_init(&script, 64)) return 1;
+
+    while(script.size < size){
+        ph_buffer_write(&script, (unsigned char*)cmd_script,
+                        sizeof(cmd_script)-1);
+        copies++;
+    }
+
+    for(i=0;i<runs;i++){
+        double start;
+        double time;
+        int rc;
+
+        if(ph_conv_init(&conv, &ph_commands, NULL)){
+            ph_buffer_free(&script);
+            return 1;
+        }
+
+        start = now();
+        rc = ph_conv_convert_mem(&conv, script.data, script.size);
+        time = now()-start;
+
+        if(rc){
+            fprintf(stderr, "Conversion failed: %s\n",
+                    ph_conv_get_error(&conv));
+            ph_conv_free(&conv);
+            ph_buffer_free(&script);
+            return 1;
+        }
+        ph_conv_free(&conv);
+
+        if(!i || time < best) best = time;
+    }
+
+    report("conv-cmds", script.size, best);
+    printf("%-12s %10.2f Mcmd/s\n", "conv-cmds",
+           copies*PH_BENCH_CMD_SCRIPT_CMDS/best/1e6);
+
+    ph_buffer_free(&script);
+
+    return 0;
+}
+
+#define PH_BENCH_LOOKUPS 1000000
+
+static void bench_lookup(void) {
+    const PHHash *names = ph_commands.names;
+    volatile size_t found = 0;
+    double start;
+    size_t i, n;
+
+    /* Perfect hash lookup */
+    start = now();
+    for(i=0;i<PH_BENCH_LOOKUPS;i++){
+        const char *name = names->names[i%names->count];
+
+        found += ph_hash_find(names, name, strlen(name));
+    }
+    printf("%-12s %10.2f ns/lookup\n", "lookup-hash",
+           (now()-start)*1e9/PH_BENCH_LOOKUPS);
+
+    /* Linear search, like the converter used to do */
+    start = now();
+    for(i=0;i<PH_BENCH_LOOKUPS;i++){
+        const char *name = names->names[i%names->count];
+
+        for(n=0;n<names->count;n++){
+            if(!strcmp(names->names[n], name)) break;
+        }
+        found += n;
+    }
+    printf("%-12s %10.2f ns/lookup\n", "lookup-lin",
+           (now()-start)*1e9/PH_BENCH_LOOKUPS);
+}
+
+/* Links an object with count labels, each followed by some text and a goto to
+ * another label, to check that linking scales linearly with the number of
+ * labels. */
+static int bench_link(size_t count, size_t runs) {
+    PHObjWriter writer;
+    PHBuffer payload;
+    PHBuffer obj;
+    FILE *tmp;
+    double best = 0;
+    size_t out_size = 0;
+    char name[32];
+    size_t i;
+
+    if(ph_obj_writer_init(&writer)) return 1;
+    if(ph_buffer_init(&payload, 64)){
+        ph_obj_writer_free(&writer);
+        return 1;
+    }
+    if(ph_buffer_init(&obj, 64)){
+        ph_obj_writer_free(&writer);
+        ph_buffer_free(&payload);
+        return 1;
+    }
+
+    for(i=0;i<count;i++){
+        sprintf(name, "label%lu", (unsigned long)i);
+        ph_obj_add_label(&writer, name, strlen(name), payload.size, 0);
+
+        ph_buffer_puts(&payload, (unsigned char*)"Some text. ");
+
+        ph_buffer_putc(&payload, PH_CMD_GOTO);
+        sprintf(name, "label%lu", (unsigned long)(i*7919%count));
+        ph_obj_add_reloc(&writer, PH_RELOC_LABEL, name, strlen(name),
+                         payload.size);
+    }
+
+    ph_obj_write(&writer, payload.data, payload.size, 0, &obj);
+    ph_obj_writer_free(&writer);
+    ph_buffer_free(&payload);
+
+    tmp = tmpfile();
+    if(tmp == NULL || fwrite(obj.data, 1, obj.size, tmp) != obj.size){
+        if(tmp != NULL) fclose(tmp);
+        ph_buffer_free(&obj);
+        return 1;
+    }
+    ph_buffer_free(&obj);
+    /* The linker maps the file */
+    fflush(tmp);
+
+    for(i=0;i<runs;i++){
+        PHLinker linker;
+        double start;
+        double time;
+
+        if(ph_linker_init(&linker, &ph_commands)){
+            fclose(tmp);
+            return 1;
+        }
+
+        start = now();
+        if(ph_linker_add_file(&linker, tmp) ||
+           ph_linker_link(&linker, "label0")){
+            fprintf(stderr, "Linking failed: %s\n",
+                    ph_linker_get_error(&linker));
+            ph_linker_free(&linker);
+            fclose(tmp);
+            return 1;
+        }
+        time = now()-start;
+
+        out_size = linker.out_buffer.size;
+        ph_linker_free(&linker);
+
+        if(!i || time < best) best = time;
+    }
+
+    sprintf(name, "link-%lu", (unsigned long)count);
+    printf("%-12s %10.2f ns/label %10.3f ms %10lu bytes\n", name,
+           best*1e9/count, best*1000, (unsigned long)out_size);
+
+    fclose(tmp);
+
+    return 0;
+}
+
+/* Dictionary of a linked file */
+typedef struct {
+    const unsigned char *entries;
+    const unsigned char *ends;
+    size_t count;
+} Dict;
+
+/* Reads the offset at *pos and returns the position it points to */
+static size_t read_offset(const unsigned char *data, size_t size,
+                          size_t *pos) {
+    size_t n = PH_OFFSET_SIZE(data[*pos]);
+    unsigned long int offset = 0;
+    size_t i;
+
+    if(*pos+n > size) return size;
+
+    for(i=0;i<n;i++) offset |= (unsigned long int)data[*pos+i]<<(i*8);
+    *pos += n;
+
+    /* Sign extend the offset */
+    offset >>= 2;
+    if(offset&(1UL<<(n*8-3))) offset -= 1UL<<(n*8-2);
+
+    return *pos+offset;
+}
+
+/* Appends the text from pos to text, up to the end of the file or to the end
+ * of a pooled string, expanding the dictionary entries and the pooled
+ * strings like the engine does. Returns 1 if the file can't be walked. */
+static int expand_at(const unsigned char *data, size_t size, size_t pos,
+                     const Dict *dict, unsigned char pooled, PHBuffer *text) {
+    while(pos < size){
+        unsigned char c = data[pos];
+        size_t i, start, end, n;
+
+        if(PH_BYTECODE_IS_TEXT(c)){
+            ph_buffer_putc(text, c);
+            pos++;
+            continue;
+        }
+
+        /* The pooled strings end with a NUL */
+        if(!c){
+            if(pooled) return 0;
+            pos++;
+            continue;
+        }
+
+        if(dict->entries != NULL && (PH_DICT_IS_CODE(c) ||
+                                     c == PH_CMD_DICT)){
+            if(c == PH_CMD_DICT){
+                if(pos+1 >= size) return 1;
+                i = PH_DICT_SHORT+data[pos+1];
+                pos += 2;
+            }else{
+                i = PH_DICT_INDEX(c);
+                pos++;
+            }
+            if(i >= dict->count) return 1;
+
+            start = i ? dict->ends[i*2-2]|(dict->ends[i*2-1]<<8) : 0;
+            end = dict->ends[i*2]|(dict->ends[i*2+1]<<8);
+            ph_buffer_write(text, (unsigned char*)dict->entries+start,
+                            end-start);
+            continue;
+        }
+
+        if(c == PH_CMD_TEXTREF){
+            pos++;
+            if(pos >= size) return 1;
+            if(expand_at(data, size, read_offset(data, size, &pos), dict, 1,
+                         text)){
+                return 1;
+            }
+            continue;
+        }
+
+        if(c == PH_CMD_CASES){
+            /* The names of the cases are in the pool */
+            if(pos+4 > size) return 1;
+            n = data[pos+1]|(data[pos+2]<<8);
+            pos += 4+((size_t)2<<data[pos+3])+(n+7)/8+
+                   n*PH_CASES_ENTRY_SIZE;
+            continue;
+        }
+
+        if(c == PH_CMD_VAR){
+            /* The name of the variable is replaced by its slot */
+            if(pos+2 > size) return 1;
+            pos += data[pos+1] == PH_CMD_VAR_SET ? 7 : 3;
+            continue;
+        }
+
+        n = ph_bytecode_cmd_size(data+pos, size-pos);
+        if(!n) return 1;
+        pos += n;
+
+        /* Skip the label offsets */
+        if((PH_BYTECODE_OPS(c)&PH_OPS_LABEL) && pos < size){
+            pos += PH_OFFSET_SIZE(data[pos]);
+        }
+    }
+
+    return pos != size || pooled;
+}
+
+/* Appends the text of a linked file to text. The pool is walked too, its
+ * strings end up in both the raw and the compressed text. */
+static int expand(const unsigned char *data, size_t size, PHBuffer *text) {
+    Dict dict;
+    size_t pos = 0;
+
+    dict.entries = NULL;
+    dict.ends = NULL;
+    dict.count = 0;
+
+    if(size >= 3 && data[0] == PH_CMD_DICT){
+        dict.count = data[1]|(data[2]<<8);
+        dict.ends = data+3;
+        dict.entries = dict.ends+dict.count*2;
+        pos = 3+dict.count*2;
+        if(dict.count){
+            pos += dict.ends[dict.count*2-2]|(dict.ends[dict.count*2-1]<<8);
+        }
+    }
+
+    return expand_at(data, size, pos, &dict, 0, text);
+}
+
+static int link_files(FILE *objs, unsigned char compress, PHBuffer *out,
+                      double *time) {
+    PHLinker linker;
+    double start;
+
+    rewind(objs);
+
+    if(ph_linker_init(&linker, &ph_commands)) return 1;
+    linker.compress = compress;
+
+    start = now();
+    if(ph_linker_add_file(&linker, objs) ||
+       ph_linker_link(&linker, "main")){
+        fprintf(stderr, "Linking failed: %s\n", ph_linker_get_error(&linker));
+        ph_linker_free(&linker);
+        return 1;
+    }
+    *time = now()-start;
+
+    ph_buffer_truncate(out, 0);
+    ph_buffer_write(out, linker.out_buffer.data, linker.out_buffer.size);
+
+    ph_linker_free(&linker);
+
+    return 0;
+}
+
+/* Compares the size of the raw and compressed output of the input files, the
+ * time needed to link them and to expand their text. */
+static int bench_compress(char **paths, size_t count, size_t runs) {
+    static char *names[2][3] = {
+        {"link-raw", "expand-raw", "size-raw"},
+        {"link-dict", "expand-dict", "size-dict"}
+    };
+    PHBuffer images[2];
+    PHBuffer texts[2];
+    FILE *objs;
+    size_t i;
+    int mode;
+    int rc = 0;
+
+    objs = tmpfile();
+    if(objs == NULL) return 1;
+
+    for(i=0;i<count;i++){
+        PHConv conv;
+        FILE *in;
+
+        in = fopen(paths[i], "rb");
+        if(in == NULL){
+            fclose(objs);
+            return 1;
+        }
+
+        if(ph_conv_init(&conv, &ph_commands, NULL)){
+            fclose(in);
+            fclose(objs);
+            return 1;
+        }
+        if(ph_conv_convert(&conv, in) != PH_CONV_SUCCESS ||
+           fwrite(conv.buffer.data, 1, conv.buffer.size, objs) !=
+           conv.buffer.size){
+            fprintf(stderr, "%s: Conversion failed: %s\n", paths[i],
+                    ph_conv_get_error(&conv));
+            rc = 1;
+        }
+
+        ph_conv_free(&conv);
+        fclose(in);
+
+        if(rc){
+            fclose(objs);
+            return 1;
+        }
+    }
+    fflush(objs);
+
+    for(mode=0;mode<2;mode++){
+        if(ph_buffer_init(images+mode, 64)) return 1;
+        if(ph_buffer_init(texts+mode, 64)) return 1;
+    }
+
+    for(mode=0;mode<2;mode++){
+        double best_link = 0;
+        double best_expand = 0;
+
+        for(i=0;i<runs;i++){
+            double time;
+            double start;
+
+            if(link_files(objs, mode, images+mode, &time)){
+                rc = 1;
+                break;
+            }
+            if(!i || time < best_link) best_link = time;
+
+            ph_buffer_truncate(texts+mode, 0);
+
+            start = now();
+            if(expand(images[mode].data, images[mode].size, texts+mode)){
+                fprintf(stderr, "%s: Invalid output!\n", names[mode][0]);
+                rc = 1;
+                break;
+            }
+            time = now()-start;
+            if(!i || time < best_expand) best_expand = time;
+        }
+        if(rc) break;
+
+        printf("%-12s %10.3f ms\n", names[mode][0], best_link*1000);
+        report(names[mode][1], texts[mode].size, best_expand);
+        printf("%-12s %10lu bytes %9.1f %%\n", names[mode][2],
+               (unsigned long)images[mode].size,
+               images[mode].size*100.0/images[0].size);
+    }
+
+    if(!rc && (texts[0].size != texts[1].size ||
+               memcmp(texts[0].data, texts[1].data, texts[0].size))){
+        fprintf(stderr, "The compressed text differs from the raw text!\n");
+        rc = 1;
+    }
+
+    for(mode=0;mode<2;mode++){
+        ph_buffer_free(images+mode);
+        ph_buffer_free(texts+mode);
+    }
+
+    fclose(objs);
+
+    return rc;
+}
+
+#define PH_BENCH_BUFFER_SIZE (50*1024*1024)
+
+static int bench_buffer(void) {
+    static char *names[3] = {
+        "buf-linear",
+        "buf-geom",
+        "buf-reserve"
+    };
+    int mode;
+
+    for(mode=0;mode<3;mode++){
+        PHBuffer buffer;
+        double start;
+        double time;
+        size_t i;
+
+        start = now();
+
+        if(ph_buffer_init(&buffer, 64)) return 1;
+
+        if(mode == 0) ph_buffer_set_growth(&buffer, PH_BUFFER_GROW_LINEAR);
+        if(mode == 2 && ph_buffer_reserve(&buffer, PH_BENCH_BUFFER_SIZE)){
+            ph_buffer_free(&buffer);
+            return 1;
+        }
+
+        for(i=0;i<PH_BENCH_BUFFER_SIZE;i++){
+            if(ph_buffer_putc(&buffer, i)){
+                ph_buffer_free(&buffer);
+                return 1;
+            }
+        }
+        ph_buffer_shrink(&buffer);
+
+        time = now()-start;
+
+        report(names[mode], PH_BENCH_BUFFER_SIZE, time);
+        printf("%-12s %10lu reallocs\n", names[mode],
+               (unsigned long)buffer.reallocs);
+
+        ph_buffer_free(&buffer);
+    }
+
+    return 0;
+}
+
+/* Checks that the bulk copy of plain chars and the vectorized scanner give the
+ * same results as the byte by byte path. */
+static int check_bulk(const unsigned char *data, size_t size, char *name) {
+    PHConv bulk, scalar;
+    size_t i;
+    int rc = 0;
+
+    for(i=0;i<size;i++){
+        if(ph_scan_plain(data+i, size-i) !=
+           ph_scan_plain_scalar(data+i, size-i)){
+            fprintf(stderr, "%s: Scanner mismatch at byte %lu!\n", name,
+                    (unsigned long)i);
+            return 1;
+        }
+    }
+
+    if(ph_conv_init(&bulk, &ph_commands, NULL)) return 1;
+    if(ph_conv_init(&scalar, &ph_commands, NULL)){
+        ph_conv_free(&bulk);
+        return 1;
+    }
+    scalar.bulk = 0;
+
+    ph_conv_convert_mem(&bulk, data, size);
+    ph_conv_convert_mem(&scalar, data, size);
+
+    if(bulk.error != scalar.error || bulk.line != scalar.line ||
+       bulk.buffer.size != scalar.buffer.size ||
+       memcmp(bulk.buffer.data, scalar.buffer.data, bulk.buffer.size)){
+        fprintf(stderr, "%s: Bulk and scalar outputs differ!\n", name);
+        rc = 1;
+    }
+
+    ph_conv_free(&bulk);
+    ph_conv_free(&scalar);
+
+    return rc;
+}
+
+static int bench_conv(FILE *in, size_t size, size_t runs) {
+    static char *names[PH_BENCH_INPUT_AMOUNT] = {
+        "conv-mmap",
+        "conv-block",
+        "conv-byte",
+        "conv-scalar"
+    };
+    int mode;
+
+    for(mode=0;mode<PH_BENCH_INPUT_AMOUNT;mode++){
+        double best = 0;
+        size_t i;
+
+        for(i=0;i<runs;i++){
+            double time;
+
+            if(convert(in, mode, &time)) return 1;
+            if(!i || time < best) best = time;
+        }
+
+        report(names[mode], size, best);
+    }
+
+    return 0;
+}
+
+static void report_stats(char *name, size_t size, double time,
+                         PHStats *stats, unsigned char machine) {
+    if(machine){
+        printf("bench=%s bytes=%lu ms=%.3f mib_s=%.2f peak_rss_kib=%ld",
+               name, (unsigned long)size, time*1000,
+               size/(1024.0*1024.0)/time, stats->peak_rss);
+        if(ph_stats_allocs){
+            printf(" allocs=%lu reallocs=%lu", stats->allocs,
+                   stats->reallocs);
+        }
+        putchar('\n');
+        return;
+    }
+
+    report(name, size, time);
+    printf("%-12s %10ld KiB peak RSS\n", name, stats->peak_rss);
+    if(ph_stats_allocs){
+        printf("%-12s %10lu allocs %10lu reallocs\n", name, stats->allocs,
+               stats->reallocs);
+    }
+}
+
+/* Converts and links a synthetic source, and reports the time and the memory
+ * used by each step separately. The stats are the ones of the last run. */
+static int bench_synth(PHGen *gen, size_t runs, unsigned char machine) {
+    PHBuffer source;
+    PHBuffer obj;
+    PHStats stats;
+    /* Peak usage and chunks of the scratch and label name arenas */
+    PHArena arenas[2];
+    FILE *tmp;
+    double best = 0;
+    size_t out_size = 0;
+    size_t i;
+
+    if(ph_buffer_init(&source, 64)) return 1;
+    if(ph_buffer_init(&obj, 64)){
+        ph_buffer_free(&source);
+        return 1;
+    }
+
+    if(ph_gen_script(gen, &source)){
+        ph_buffer_free(&source);
+        ph_buffer_free(&obj);
+        return 1;
+    }
+
+    if(machine){
+        printf("bench=gen labels=%lu prose=%lu cases=%lu density=%lu "
+               "verbatim=%lu bytes=%lu runs=%lu\n",
+               (unsigned long)gen->labels, (unsigned long)gen->prose,
+               (unsigned long)gen->cases, (unsigned long)gen->density,
+               (unsigned long)gen->verbatim, (unsigned long)source.size,
+               (unsigned long)runs);
+    }else{
+        printf("synthetic: %lu labels, %lu bytes, best of %lu runs\n",
+               (unsigned long)gen->labels, (unsigned long)source.size,
+               (unsigned long)runs);
+    }
+
+    for(i=0;i<runs;i++){
+        PHConv conv;
+        double start;
+        double time;
+
+        ph_stats_start(&stats);
+
+        if(ph_conv_init(&conv, &ph_commands, NULL)){
+            ph_buffer_free(&source);
+            ph_buffer_free(&obj);
+            return 1;
+        }
+
+        start = now();
+        if(ph_conv_convert_mem(&conv, source.data, source.size)){
+            fprintf(stderr, "Conversion failed: %s\n",
+                    ph_conv_get_error(&conv));
+            ph_conv_free(&conv);
+            ph_buffer_free(&source);
+            ph_buffer_free(&obj);
+            return 1;
+        }
+        time = now()-start;
+
+        ph_buffer_truncate(&obj, 0);
+        ph_buffer_write(&obj, conv.buffer.data, conv.buffer.size);
+        ph_conv_free(&conv);
+
+        ph_stats_end(&stats);
+
+        if(!i || time < best) best = time;
+    }
+
+    report_stats("synth-conv", source.size, best, &stats, machine);
+    ph_buffer_free(&source);
+
+    tmp = tmpfile();
+    if(tmp == NULL || fwrite(obj.data, 1, obj.size, tmp) != obj.size){
+        if(tmp != NULL) fclose(tmp);
+        ph_buffer_free(&obj);
+        return 1;
+    }
+    /* The linker maps the file */
+    fflush(tmp);
+
+    for(i=0;i<runs;i++){
+        PHLinker linker;
+        double start;
+        double time;
+
+        ph_stats_start(&stats);
+
+        if(ph_linker_init(&linker, &ph_commands)){
+            fclose(tmp);
+            ph_buffer_free(&obj);
+            return 1;
+        }
+
+        start = now();
+        if(ph_linker_add_file(&linker, tmp) ||
+           ph_linker_link(&linker, "main")){
+            fprintf(stderr, "Linking failed: %s\n",
+                    ph_linker_get_error(&linker));
+            ph_linker_free(&linker);
+            fclose(tmp);
+            ph_buffer_free(&obj);
+            return 1;
+        }
+        time = now()-start;
+
+        out_size = linker.out_buffer.size;
+        arenas[0] = linker.scratch;
+        arenas[1] = linker.labels.names;
+        ph_linker_free(&linker);
+
+        ph_stats_end(&stats);
+
+        if(!i || time < best) best = time;
+    }
+
+    report_stats("synth-link", obj.size, best, &stats, machine);
+    for(i=0;i<2;i++){
+        char *name = i ? "synth-names" : "synth-scratch";
+
+        if(machine){
+            printf("bench=%s peak=%lu chunks=%lu allocs=%lu\n", name,
+                   (unsigned long)arenas[i].peak,
+                   (unsigned long)arenas[i].chunk_count,
+                   (unsigned long)arenas[i].alloc_count);
+        }else{
+            printf("%-12s %10lu bytes %10lu chunks %10lu allocs\n", name,
+                   (unsigned long)arenas[i].peak,
+                   (unsigned long)arenas[i].chunk_count,
+                   (unsigned long)arenas[i].alloc_count);
+        }
+    }
+    if(machine){
+        printf("bench=synth-out bytes=%lu\n", (unsigned long)out_size);
+    }else{
+        printf("%-12s %10lu bytes\n", "synth-out", (unsigned long)out_size);
+    }
+
+    fclose(tmp);
+    ph_buffer_free(&obj);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int opt;
+
+    size_t runs = 3;
+    size_t size = 16;
+
+    unsigned char synth = 0;
+    unsigned char machine = 0;
+    PHGen gen;
+
+    PHBuffer source;
+    FILE *tmp;
+
+    ph_gen_init(&gen);
+
+    while((opt = getopt(argc, argv, "hgmn:s:L:P:C:D:V:")) != -1){
+        switch(opt){
+            case 'h':
+                fprintf(stderr, help_str, argv[0]);
+                fputs(gen_help_str, stderr);
+                return EXIT_SUCCESS;
+            case 'g':
+                synth = 1;
+                break;
+            case 'm':
+                machine = 1;
+                break;
+            case 'L':
+                gen.labels = strtoul(optarg, NULL, 10);
+                if(!gen.labels) gen.labels = 1;
+                break;
+            case 'P':
+                gen.prose = strtoul(optarg, NULL, 10)*1024;
+                break;
+            case 'C':
+                gen.cases = strtoul(optarg, NULL, 10);
+                break;
+            case 'D':
+                gen.density = strtoul(optarg, NULL, 10);
+                break;
+            case 'V':
+                gen.verbatim = strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                runs = strtoul(optarg, NULL, 10);
+                if(!runs) runs = 1;
+                break;
+            case 's':
+                size = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, help_str, argv[0]);
+                fputs(gen_help_str, stderr);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if(synth){
+        return bench_synth(&gen, runs, machine) ? EXIT_FAILURE :
+                                                  EXIT_SUCCESS;
+    }
+
+    if(!argv[optind]){
+        fprintf(stderr, "%s: No input files!\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size *= 1024*1024;
+
+    /* Build the benchmark input by repeating the input files */
+
+    if(ph_buffer_init(&source, 64)){
+        fprintf(stderr, "%s: Internal error!\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    do{
+        int i;
+
+        for(i=optind;i<argc;i++){
+            PHInput input;
+            FILE *in = fopen(argv[i], "rb");
+
+            if(in == NULL){
+                fprintf(stderr, "%s: Failed to open %s!\n", argv[0], argv[i]);
+                ph_buffer_free(&source);
+                return EXIT_FAILURE;
+            }
+            if(ph_input_open(&input, in)){
+                fprintf(stderr, "%s: Failed to read %s!\n", argv[0], argv[i]);
+                fclose(in);
+                ph_buffer_free(&source);
+                return EXIT_FAILURE;
+            }
+
+            if(check_bulk(input.data, input.size, argv[i])){
+                ph_input_close(&input);
+                fclose(in);
+                ph_buffer_free(&source);
+                return EXIT_FAILURE;
+            }
+
+            ph_buffer_write(&source, (unsigned char*)input.data, input.size);
+            ph_buffer_putc(&source, '\n');
+
+            ph_input_close(&input);
+            fclose(in);
+        }
+    }while(source.size < size);
+
+    tmp = tmpfile();
+    if(tmp == NULL ||
+       fwrite(source.data, 1, source.size, tmp) != source.size){
+        fprintf(stderr, "%s: Failed to write the benchmark input!\n",
+                argv[0]);
+        if(tmp != NULL) fclose(tmp);
+        ph_buffer_free(&source);
+        return EXIT_FAILURE;
+    }
+    fflush(tmp);
+
+    if(check_bulk(source.data, source.size, "input")){
+        fclose(tmp);
+        ph_buffer_free(&source);
+        return EXIT_FAILURE;
+    }
+
+    printf("input: %lu bytes, best of %lu runs\n",
+           (unsigned long)source.size, (unsigned long)runs);
+
+    if(bench_conv(tmp, source.size, runs) || bench_cmds(size, runs) ||
+       bench_buffer() || bench_link(100, runs) || bench_link(1000, runs) ||
+       bench_link(10000, runs) || bench_link(100000, runs) ||
+       bench_compress(argv+optind, argc-optind, runs)){
+        fclose(tmp);
+        ph_buffer_free(&source);
+        return EXIT_FAILURE;
+    }
+
+    bench_lookup();
+
+    fclose(tmp);
+    ph_buffer_free(&source);
+
+    return EXIT_SUCCESS;
+}
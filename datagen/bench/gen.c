@@ -0,0 +1,172 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gen.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *const words[] = {
+    "the", "a", "door", "dark", "corridor", "old", "lamp", "you", "see",
+    "north", "south", "stairs", "water", "drips", "from", "ceiling", "cold",
+    "stone", "wall", "key", "rusty", "table", "is", "on", "there", "light",
+    "behind", "wooden", "chest", "silent", "room", "and"
+};
+
+#define PH_GEN_WORDS (sizeof(words)/sizeof(*words))
+
+/* Commands put between the prose lines */
+static const char *const cmds[] = {
+    "#halign center\n",
+    "#halign left\n",
+    "#valign top\n",
+    "#setx 2\n",
+    "#delay 10\n",
+    "#note C-4 100\n",
+    "#pagebreak\n"
+};
+
+#define PH_GEN_CMDS (sizeof(cmds)/sizeof(*cmds))
+
+static const char verbatim[] =
+    "#startverbatim\n"
+    "   _______________\n"
+    "  |  ___________  |\n"
+    "  | |  -=( )=-  | |\n"
+    "  | |___________| |\n"
+    "  |_______________|\n"
+    "#endverbatim\n";
+
+/* Length of the prose lines */
+#define PH_GEN_LINE 60
+
+void ph_gen_init(PHGen *gen) {
+    gen->labels = 1000;
+    gen->prose = 1024*1024;
+    gen->cases = 4;
+    gen->density = 10;
+    gen->verbatim = 16;
+    gen->seed = 1;
+}
+
+static size_t ph_gen_rand(PHGen *gen, size_t max) {
+    gen->seed = (gen->seed*1103515245UL+12345UL)&0xFFFFFFFFUL;
+
+    return (gen->seed>>16)%max;
+}
+
+static int ph_gen_label(PHBuffer *out, size_t i) {
+    char name[32];
+
+    if(i) sprintf(name, "l%lu", (unsigned long)i);
+    else strcpy(name, "main");
+
+    return ph_buffer_puts(out, (unsigned char*)name);
+}
+
+static int ph_gen_prose(PHGen *gen, PHBuffer *out, size_t size) {
+    size_t line = 0;
+    size_t end = out->size+size;
+
+    while(out->size < end){
+        const char *word = words[ph_gen_rand(gen, PH_GEN_WORDS)];
+
+        if(!line && ph_gen_rand(gen, 100) < gen->density){
+            if(ph_buffer_puts(out, (unsigned char*)cmds[ph_gen_rand(gen,
+                                                            PH_GEN_CMDS)])){
+                return 1;
+            }
+        }
+
+        if(ph_buffer_puts(out, (unsigned char*)word)) return 1;
+        line += strlen(word);
+
+        if(line >= PH_GEN_LINE){
+            if(ph_buffer_write(out, (unsigned char*)".\n", 2)) return 1;
+            line = 0;
+        }else{
+            if(ph_buffer_putc(out, ' ')) return 1;
+            line++;
+        }
+    }
+
+    if(line){
+        /* Replace the space after the last word */
+        ph_buffer_truncate(out, out->size-1);
+        return ph_buffer_write(out, (unsigned char*)".\n", 2);
+    }
+
+    return 0;
+}
+
+int ph_gen_script(PHGen *gen, PHBuffer *out) {
+    size_t blocks = 0;
+    size_t i, n;
+
+    if(!gen->labels) return 1;
+
+    for(i=0;i<gen->labels;i++){
+        if(ph_buffer_puts(out, (unsigned char*)"#label ") ||
+           ph_gen_label(out, i) ||
+           ph_buffer_puts(out, (unsigned char*)"\n#clear\n")){
+            return 1;
+        }
+
+        if(ph_gen_prose(gen, out, gen->prose/gen->labels)) return 1;
+
+        /* Spread the verbatim blocks evenly */
+        while(blocks < gen->verbatim &&
+              blocks*gen->labels <= i*gen->verbatim){
+            if(ph_buffer_puts(out, (unsigned char*)verbatim)) return 1;
+            blocks++;
+        }
+
+        for(n=0;n<gen->cases;n++){
+            char name[32];
+
+            sprintf(name, "#case %s%lu ",
+                    words[ph_gen_rand(gen, PH_GEN_WORDS)], (unsigned long)n);
+            if(ph_buffer_puts(out, (unsigned char*)name) ||
+               ph_gen_label(out, ph_gen_rand(gen, gen->labels)) ||
+               ph_buffer_putc(out, '\n')){
+                return 1;
+            }
+        }
+
+        if(ph_buffer_puts(out, (unsigned char*)"#askc\n")) return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHOSPHOR_GEN_H
+#define PHOSPHOR_GEN_H
+
+#include <stddef.h>
+
+#include <buffer.h>
+
+/* Parameters of a synthetic adventure source. The same parameters always give
+ * the same source. */
+typedef struct {
+    /* Number of labels, the first one is main */
+    size_t labels;
+    /* Bytes of prose, split evenly between the labels */
+    size_t prose;
+    /* Number of cases before the ask that ends each label */
+    size_t cases;
+    /* Percentage of the prose lines that are preceded by a command */
+    size_t density;
+    /* Number of verbatim blocks, spread over the labels */
+    size_t verbatim;
+
+    unsigned long int seed;
+} PHGen;
+
+void ph_gen_init(PHGen *gen);
+int ph_gen_script(PHGen *gen, PHBuffer *out);
+
+#endif
@@ -0,0 +1,113 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stats.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sys/resource.h>
+
+static unsigned long int allocs;
+static unsigned long int reallocs;
+
+#ifdef __GLIBC__
+
+/* The allocator of glibc can be replaced by defining malloc and co. in the
+ * program, these ones count the calls and use the glibc allocator. */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+    allocs++;
+
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocs++;
+
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    reallocs++;
+
+    return __libc_realloc(ptr, size);
+}
+
+const int ph_stats_allocs = 1;
+
+#else
+
+const int ph_stats_allocs = 0;
+
+#endif
+
+void ph_stats_start(PHStats *stats) {
+    FILE *fp;
+
+    /* Reset the peak RSS on Linux, it is the peak of the whole process
+     * otherwise */
+    fp = fopen("/proc/self/clear_refs", "w");
+    if(fp != NULL){
+        fputs("5", fp);
+        fclose(fp);
+    }
+
+    stats->allocs = allocs;
+    stats->reallocs = reallocs;
+}
+
+void ph_stats_end(PHStats *stats) {
+    struct rusage usage;
+
+    stats->allocs = allocs-stats->allocs;
+    stats->reallocs = reallocs-stats->reallocs;
+
+    stats->peak_rss = -1;
+    if(!getrusage(RUSAGE_SELF, &usage)){
+        /* ru_maxrss is in KiB on Linux and in bytes on macOS */
+#ifdef __APPLE__
+        stats->peak_rss = usage.ru_maxrss/1024;
+#else
+        stats->peak_rss = usage.ru_maxrss;
+#endif
+    }
+}
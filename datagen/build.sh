@@ -39,24 +39,33 @@ help="USAGE: $0 [-d]\n"\
 "A small tool to compile the Phosphor Engine game "\
 "binary.\n\n"\
 "Options:\n"\
-"-d  Debug build (-O0 and no LTO)"
+"-d  Debug build (-O0 and no LTO)\n"\
+"-b  Also build the benchmarks"
 
 cc=clang
 ld=clang
 
-cflags=(-ansi -Wall -Wextra -Wpedantic -Isrc -I../shared)
-ldflags=()
+cflags=(-ansi -Wall -Wextra -Wpedantic -pthread -Isrc -I../shared)
+ldflags=(-pthread)
 
 builddir=build
+gendir=$builddir/gen
 
 name=main
 srcdir=src
 
+benchname=benchmark
+benchdir=bench
+
+cflags+=(-I$gendir)
+
 debug=false
+bench=false
 
-while getopts "dh" flag; do
+while getopts "dbh" flag; do
     case "${flag}" in
         d) debug=true ;;
+        b) bench=true ;;
         h) echo -e $help
            exit 0 ;;
     esac
@@ -78,6 +87,7 @@ echo "-- Entering $rootdir..."
 cd $rootdir
 
 mkdir -p $builddir
+mkdir -p $gendir
 
 objfiles=()
 
@@ -91,6 +101,13 @@ errorcheck() {
     fi
 }
 
+# Generate the perfect hash tables of the command names
+echo "-- Generating $gendir/commandhash.h..."
+$cc gen/hashgen.c $srcdir/hash.c -o $builddir/hashgen ${cflags[@]}
+errorcheck
+$builddir/hashgen > $gendir/commandhash.h
+errorcheck
+
 for i in $(find $srcdir -mindepth 1 -type f \( -name "*.c" -o -name "*.s" \
            -o -name "*.S" \)); do
     obj=$builddir/${i#$srcdir*}.o
@@ -107,6 +124,31 @@ $ld ${objfiles[@]} -o $name ${ldflags[@]}
 
 errorcheck
 
+if [ $bench = true ]; then
+    benchobjs=()
+
+    for i in $(find $benchdir -mindepth 1 -type f -name "*.c"); do
+        obj=$builddir/$i.o
+        echo "-- Compiling ${i} to ${obj}..."
+        mkdir -p $(dirname $obj)
+        $cc -c $i -o $obj ${cflags[@]} -I$benchdir
+        errorcheck
+        benchobjs+=($obj)
+    done
+
+    # The benchmarks have their own main function
+    for i in ${objfiles[@]}; do
+        if [ $(basename $i) != main.c.o ]; then
+            benchobjs+=($i)
+        fi
+    done
+
+    echo "-- Linking $benchname..."
+    $ld ${benchobjs[@]} -o $benchname ${ldflags[@]}
+
+    errorcheck
+fi
+
 echo "-- Exiting $rootdir..."
 cd $orgdir
 echo "-- Build succeeded!"
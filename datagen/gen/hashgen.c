@@ -0,0 +1,147 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Generates the perfect hash tables used to look up command and subcommand
+ * names. The tables are written to stdout as a C header. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+
+#include <hash.h>
+#include <commandtable.h>
+
+/* Maximum amount of seeds tried for each table size */
+#define PH_HASHGEN_TRIES 100000
+
+#define _CMD(name, fnc, id, ops) name,
+#define _SUB(name, id) name,
+
+static const char *const cmds[] = {PH_CMD_TABLE(_CMD) NULL};
+static const char *const var_subcmds[] = {PH_VAR_SUBCMDS(_SUB) NULL};
+static const char *const math_subcmds[] = {PH_MATH_SUBCMDS(_SUB) NULL};
+static const char *const tmp_subcmds[] = {PH_TMP_SUBCMDS(_SUB) NULL};
+static const char *const branch_subcmds[] = {PH_BRANCH_SUBCMDS(_SUB) NULL};
+static const char *const io_subcmds[] = {PH_IO_SUBCMDS(_SUB) NULL};
+static const char *const ext_subcmds[] = {PH_EXT_SUBCMDS(_SUB) NULL};
+
+static int generate(char *id, const char *const *names) {
+    static unsigned char slots[256];
+    size_t count;
+    size_t i;
+
+    unsigned char bits;
+    unsigned long int seed;
+
+    for(count=0;names[count] != NULL;count++);
+
+    if(count > 255){
+        fprintf(stderr, "hashgen: Too many names in %s!\n", id);
+        return 1;
+    }
+
+    /* Keep the load factor at or below 1/2 */
+    for(bits=0;(1UL<<bits) < count*2;bits++);
+
+    for(;bits<=8;bits++){
+        for(seed=0;seed<PH_HASHGEN_TRIES;seed++){
+            memset(slots, 0, sizeof(slots));
+
+            for(i=0;i<count;i++){
+                size_t slot = ph_hash_slot(ph_hash_string(seed, names[i],
+                                                          strlen(names[i])),
+                                           bits);
+
+                if(slots[slot]) break;
+                slots[slot] = i+1;
+            }
+
+            if(i == count) break;
+        }
+
+        if(seed < PH_HASHGEN_TRIES) break;
+    }
+
+    if(bits > 8){
+        fprintf(stderr, "hashgen: Failed to find a perfect hash for %s!\n",
+                id);
+        return 1;
+    }
+
+    printf("static const char *const ph_hash_%s_names[] = {\n", id);
+    for(i=0;i<count;i++){
+        printf("    \"%s\",\n", names[i]);
+    }
+    printf("    NULL\n};\n\n");
+
+    printf("static const unsigned char ph_hash_%s_slots[%lu] = {", id,
+           1UL<<bits);
+    for(i=0;i<(1UL<<bits);i++){
+        if(!(i%16)) printf("\n    ");
+        printf("%u%s", slots[i], i+1 < (1UL<<bits) ? ", " : "\n");
+    }
+    printf("};\n\n");
+
+    printf("static const PHHash ph_hash_%s = {\n"
+           "    0x%08lXUL,\n"
+           "    %u,\n"
+           "    ph_hash_%s_slots,\n"
+           "    ph_hash_%s_names,\n"
+           "    %lu\n"
+           "};\n\n", id, seed, bits, id, id, (unsigned long)count);
+
+    return 0;
+}
+
+int main(void) {
+    printf("/* Generated by hashgen, do not edit! */\n\n"
+           "#ifndef PHOSPHOR_COMMANDHASH_H\n"
+           "#define PHOSPHOR_COMMANDHASH_H\n\n"
+           "#include <stddef.h>\n"
+           "#include <hash.h>\n\n");
+
+    if(generate("cmd", cmds)) return EXIT_FAILURE;
+    if(generate("var", var_subcmds)) return EXIT_FAILURE;
+    if(generate("math", math_subcmds)) return EXIT_FAILURE;
+    if(generate("tmp", tmp_subcmds)) return EXIT_FAILURE;
+    if(generate("branch", branch_subcmds)) return EXIT_FAILURE;
+    if(generate("io", io_subcmds)) return EXIT_FAILURE;
+    if(generate("ext", ext_subcmds)) return EXIT_FAILURE;
+
+    printf("#endif\n");
+
+    return EXIT_SUCCESS;
+}
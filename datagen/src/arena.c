@@ -37,72 +37,141 @@
 
 #include <stdlib.h>
 
+/* Alignment of the largest types, the chunks are aligned on it */
+typedef union {
+    long int l;
+    double d;
+    void *p;
+    size_t s;
+} PHArenaAlign;
+
+#define PH_ARENA_ALIGN sizeof(PHArenaAlign)
+
+/* Size of the chunk header, rounded up to keep the data aligned */
+#define PH_ARENA_HEADER \
+    ((sizeof(PHArenaChunk)+PH_ARENA_ALIGN-1)/PH_ARENA_ALIGN*PH_ARENA_ALIGN)
+
+#define PH_ARENA_DATA(chunk) ((unsigned char*)(chunk)+PH_ARENA_HEADER)
+
 int ph_arena_init(PHArena *arena, size_t chunk_size) {
-    arena->chunk_size = chunk_size;
+    arena->chunk = NULL;
+    arena->spare = NULL;
 
-    arena->current_chunk_size = arena->chunk_size;
+    arena->chunk_size = chunk_size ? chunk_size : PH_ARENA_ALIGN;
+    arena->usage = 0;
 
-    arena->data = malloc(sizeof(void*));
-    if(arena->data == NULL){
-        return 1;
-    }
+    arena->chunk_count = 0;
+    arena->alloc_count = 0;
+    arena->used = 0;
+    arena->peak = 0;
+    arena->reserved = 0;
+
+    return 0;
+}
+
+/* Makes a chunk of at least size bytes the current one */
+static int ph_arena_grow(PHArena *arena, size_t size) {
+    PHArenaChunk *chunk;
+
+    if(arena->spare != NULL && arena->spare->size >= size){
+        chunk = arena->spare;
+        arena->spare = NULL;
+    }else{
+        size_t chunk_size = arena->chunk_size;
 
-    arena->data[0] = malloc(chunk_size);
-    if(arena->data[0] == NULL){
-        free(arena->data);
-        arena->data = NULL;
-        return 1;
+        while(chunk_size < size) chunk_size *= 2;
+
+        chunk = malloc(PH_ARENA_HEADER+chunk_size);
+        if(chunk == NULL) return 1;
+
+        chunk->size = chunk_size;
+        arena->chunk_size = chunk_size*2;
+        arena->chunk_count++;
+        arena->reserved += chunk_size;
     }
 
-    arena->current_chunk = 0;
+    /* The end of the previous chunk is lost */
+    if(arena->chunk != NULL) arena->used += arena->chunk->size-arena->usage;
 
+    chunk->prev = arena->chunk;
+    arena->chunk = chunk;
     arena->usage = 0;
 
     return 0;
 }
 
+/* Allocates num elements of size bytes, aligned on the largest power of two
+ * that divides size, up to the alignment of the largest types */
 void *ph_arena_alloc(PHArena *arena, size_t size, size_t num) {
-    size_t start = arena->usage+(size-arena->usage%size);
-    size_t end = start+size*num;
+    size_t align = size & (~size+1);
+    size_t start;
+    size_t bytes;
+
+    if(!size || num > (size_t)-1/size) return NULL;
+    bytes = size*num;
 
-    if(arena->data == NULL) return NULL;
+    if(align > PH_ARENA_ALIGN) align = PH_ARENA_ALIGN;
 
-    if(end > arena->current_chunk_size){
-        size_t new_chunk_size = size*num > arena->chunk_size ?
-                                size*num : arena->chunk_size;
-        void *new;
+    start = (arena->usage+align-1)&~(align-1);
+    if(arena->chunk == NULL || start > arena->chunk->size ||
+       bytes > arena->chunk->size-start){
+        if(ph_arena_grow(arena, bytes)) return NULL;
+        start = 0;
+    }
 
-        new = realloc(arena->data, (arena->current_chunk+2)*sizeof(void*));
-        if(new == NULL) return NULL;
+    arena->used += start-arena->usage+bytes;
+    if(arena->used > arena->peak) arena->peak = arena->used;
+    arena->usage = start+bytes;
+    arena->alloc_count++;
 
-        arena->data = new;
+    return PH_ARENA_DATA(arena->chunk)+start;
+}
 
-        arena->current_chunk++;
+void ph_arena_mark(PHArena *arena, PHArenaMark *mark) {
+    mark->chunk = arena->chunk;
+    mark->usage = arena->usage;
+    mark->used = arena->used;
+}
 
-        arena->data[arena->current_chunk] = malloc(new_chunk_size);
-        if(arena->data[arena->current_chunk] == NULL){
-            arena->current_chunk--;
-            return NULL;
-        }
+/* Frees everything allocated after the mark */
+void ph_arena_rollback(PHArena *arena, PHArenaMark *mark) {
+    while(arena->chunk != mark->chunk){
+        PHArenaChunk *chunk = arena->chunk;
 
-        /* We successfully allocated a new chunk */
-        arena->usage = 0;
-        arena->current_chunk_size = new_chunk_size;
+        arena->chunk = chunk->prev;
 
-        /* Recalculate the sizes */
-        start = 0;
-        end = start+size*num;
+        /* Keep the largest chunk for the next allocations */
+        if(arena->spare == NULL || chunk->size > arena->spare->size){
+            PHArenaChunk *spare = arena->spare;
+
+            arena->spare = chunk;
+            chunk = spare;
+        }
+        if(chunk != NULL){
+            arena->reserved -= chunk->size;
+            free(chunk);
+        }
     }
 
-    arena->usage = end;
+    arena->usage = mark->usage;
+    arena->used = mark->used;
+}
+
+/* Frees everything, but keeps the largest chunk */
+void ph_arena_reset(PHArena *arena) {
+    PHArenaMark mark;
 
-    return (unsigned char*)arena->data[arena->current_chunk]+start;
+    mark.chunk = NULL;
+    mark.usage = 0;
+    mark.used = 0;
+
+    ph_arena_rollback(arena, &mark);
 }
+
 void ph_arena_free(PHArena *arena) {
-    size_t i;
+    ph_arena_reset(arena);
 
-    for(i=0;i<=arena->current_chunk;i++){
-        free(arena->data[i]);
-    }
-    free(arena->data);
+    free(arena->spare);
+    arena->spare = NULL;
+    arena->reserved = 0;
 }
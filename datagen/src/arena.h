@@ -39,18 +39,48 @@
 #include <stddef.h>
 
 /* NOTE: It's a bit more than a simple arena, as the arena can allocate more
- * space if needed. */
+ * space if needed. Each new chunk is twice as large as the previous one, and
+ * the memory allocated after a mark can be given back by rolling back to it.
+ * The largest chunk given back is kept to be reused. */
+
+typedef struct PHArenaChunk PHArenaChunk;
+
+struct PHArenaChunk {
+    PHArenaChunk *prev;
+    size_t size;
+};
 
 typedef struct {
-    void **data;
+    PHArenaChunk *chunk;
+    PHArenaChunk *spare;
+
+    /* Size of the next chunk */
     size_t chunk_size;
-    size_t current_chunk_size;
-    size_t current_chunk;
+    /* Bytes used in the current chunk */
     size_t usage;
+
+    /* Statistics: chunks allocated with malloc, allocations, bytes in use
+     * including the padding, highest number of bytes in use, and bytes held
+     * in chunks */
+    size_t chunk_count;
+    size_t alloc_count;
+    size_t used;
+    size_t peak;
+    size_t reserved;
 } PHArena;
 
+/* Position in an arena to roll back to */
+typedef struct {
+    PHArenaChunk *chunk;
+    size_t usage;
+    size_t used;
+} PHArenaMark;
+
 int ph_arena_init(PHArena *arena, size_t chunk_size);
 void *ph_arena_alloc(PHArena *arena, size_t size, size_t num);
+void ph_arena_mark(PHArena *arena, PHArenaMark *mark);
+void ph_arena_rollback(PHArena *arena, PHArenaMark *mark);
+void ph_arena_reset(PHArena *arena);
 void ph_arena_free(PHArena *arena);
 
 #endif
@@ -49,24 +49,65 @@ int ph_buffer_init(PHBuffer *buffer, size_t step) {
     buffer->max = step;
     buffer->step = step;
 
+    buffer->growth = PH_BUFFER_GROW_GEOMETRIC;
+    buffer->reallocs = 0;
+
+    return 0;
+}
+
+void ph_buffer_set_growth(PHBuffer *buffer, unsigned char growth) {
+    buffer->growth = growth;
+}
+
+static int ph_buffer_resize(PHBuffer *buffer, size_t new_size) {
+    unsigned char *new;
+
+    /* Avoid freeing the buffer with realloc(data, 0) */
+    if(!new_size) new_size = 1;
+
+    new = realloc(buffer->data, new_size);
+    if(new == NULL) return 1;
+
+    buffer->data = new;
+    buffer->max = new_size;
+    buffer->reallocs++;
+
     return 0;
 }
 
 int ph_buffer_alloc(PHBuffer *buffer, size_t size) {
     if(buffer->cur+size > buffer->max){
-        size_t new_size = buffer->max+((buffer->cur+size)/buffer->step+1)*
-                          buffer->step;
-        unsigned char *new;
+        size_t needed = buffer->cur+size;
+        size_t new_size;
 
-        new = realloc(buffer->data, new_size);
-        if(new == NULL) return 1;
+        if(buffer->growth == PH_BUFFER_GROW_GEOMETRIC && buffer->max*2 >
+           needed){
+            new_size = buffer->max*2;
+        }else{
+            new_size = needed;
+        }
 
-        buffer->data = new;
-        buffer->max = new_size;
+        /* Round up to a multiple of the step */
+        new_size = (new_size+buffer->step-1)/buffer->step*buffer->step;
+
+        return ph_buffer_resize(buffer, new_size);
     }
     return 0;
 }
 
+int ph_buffer_reserve(PHBuffer *buffer, size_t size) {
+    if(size > buffer->max) return ph_buffer_resize(buffer, size);
+
+    return 0;
+}
+
+int ph_buffer_shrink(PHBuffer *buffer) {
+    if(buffer->size < buffer->max) return ph_buffer_resize(buffer,
+                                                           buffer->size);
+
+    return 0;
+}
+
 int ph_buffer_write(PHBuffer *buffer, unsigned char *data, size_t size) {
     if(ph_buffer_alloc(buffer, size)) return 1;
 
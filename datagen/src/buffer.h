@@ -44,8 +44,18 @@ typedef struct {
     size_t max;
     size_t step;
     size_t cur;
+
+    unsigned char growth;
+    size_t reallocs;
 } PHBuffer;
 
+enum {
+    /* Double the capacity (amortized O(1) appends) */
+    PH_BUFFER_GROW_GEOMETRIC,
+    /* Grow by multiples of step */
+    PH_BUFFER_GROW_LINEAR
+};
+
 enum {
     PH_BUFFER_START,
     PH_BUFFER_END,
@@ -54,7 +64,10 @@ enum {
 };
 
 int ph_buffer_init(PHBuffer *buffer, size_t step);
+void ph_buffer_set_growth(PHBuffer *buffer, unsigned char growth);
 int ph_buffer_alloc(PHBuffer *buffer, size_t size);
+int ph_buffer_reserve(PHBuffer *buffer, size_t size);
+int ph_buffer_shrink(PHBuffer *buffer);
 int ph_buffer_write(PHBuffer *buffer, unsigned char *data, size_t size);
 int ph_buffer_putc(PHBuffer *buffer, unsigned char c);
 int ph_buffer_puts(PHBuffer *buffer, unsigned char *str);
@@ -0,0 +1,86 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <bytecode.h>
+
+#include <format.h>
+
+#include <string.h>
+
+/* Size of a command made of the opcode, n bytes and a string */
+static size_t ph_bytecode_str_size(const unsigned char *code, size_t size,
+                                   size_t n) {
+    const unsigned char *end;
+
+    if(size <= n+1) return 0;
+
+    end = memchr(code+n+1, 0, size-n-1);
+    if(end == NULL) return 0;
+
+    return end-code+1;
+}
+
+#define _OPS(name, fnc, id, ops) ops,
+
+const unsigned char ph_bytecode_ops[PH_CMD_DICT-PH_CMD_START] = {
+    PH_CMD_TABLE(_OPS)
+};
+
+size_t ph_bytecode_cmd_size(const unsigned char *code, size_t size) {
+    unsigned char ops;
+    size_t n;
+
+    if(!size || code[0] < PH_CMD_START || code[0] >= PH_CMD_DICT) return 0;
+
+    ops = ph_bytecode_ops[code[0]-PH_CMD_START];
+    n = 1+PH_OPS_BYTES(ops);
+
+    if(ops&PH_OPS_VAR){
+        if(size < 2) return 0;
+        if(code[1] == PH_CMD_VAR_SET) n += 4;
+    }
+
+    if(ops&PH_OPS_STR) return ph_bytecode_str_size(code, size, n-1);
+
+    return n <= size ? n : 0;
+}
+
+size_t ph_bytecode_text_size(const unsigned char *code, size_t size) {
+    size_t n;
+
+    for(n=0;n<size && PH_BYTECODE_IS_TEXT(code[n]);n++);
+
+    return n;
+}
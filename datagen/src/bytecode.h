@@ -0,0 +1,64 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHOSPHOR_BYTECODE_H
+#define PHOSPHOR_BYTECODE_H
+
+#include <stddef.h>
+
+#include <format.h>
+
+/* Walks the payload of the objects, which only contains text and commands
+ * without their label offsets. */
+
+/* Chars the converter puts in the text */
+#define PH_BYTECODE_IS_TEXT(c) (((c) >= 0x20 && (c) <= 0x7E) || \
+                                (c) >= 0xA0 || (c) == '\n' || (c) == '\t')
+
+/* Layout of the operands of the commands, PH_OPS_* flags from
+ * commandtable.h */
+extern const unsigned char ph_bytecode_ops[PH_CMD_DICT-PH_CMD_START];
+
+#define PH_BYTECODE_OPS(c) ((c) >= PH_CMD_START && (c) < PH_CMD_DICT ? \
+                            ph_bytecode_ops[(c)-PH_CMD_START] : 0)
+
+/* Returns the size of the command at the start of code, or 0 if it isn't a
+ * command or if it is truncated. */
+size_t ph_bytecode_cmd_size(const unsigned char *code, size_t size);
+
+/* Returns the number of text chars at the start of code */
+size_t ph_bytecode_text_size(const unsigned char *code, size_t size);
+
+#endif
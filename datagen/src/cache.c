@@ -0,0 +1,163 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <cache.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <hash.h>
+#include <input.h>
+#include <object.h>
+
+#include <format.h>
+
+int ph_cache_init(PHCache *cache, char *path) {
+    cache->path = path;
+
+    if(mkdir(path, 0777) && errno != EEXIST) return 1;
+
+    return 0;
+}
+
+void ph_cache_key(const unsigned char *data, size_t size, char *key) {
+    unsigned long int fnv;
+    unsigned long int djb = 5381;
+    size_t i;
+
+    /* Two unrelated 32-bit hashes to make collisions unlikely */
+    fnv = ph_hash_string(PH_CMD_VERSION, (const char*)data, size);
+    for(i=0;i<size;i++){
+        djb = ((djb*33)^data[i])&0xFFFFFFFF;
+    }
+
+    /* The cached objects can't be reused if the bytecode or the object format
+     * changed */
+    sprintf(key, "v%d.%d-%08lx%08lx-%lx", PH_CMD_VERSION, PH_OBJ_VERSION, fnv,
+            djb, (unsigned long int)size);
+}
+
+static char *ph_cache_path(PHCache *cache, char *key, char *suffix) {
+    char *path;
+
+    path = malloc(strlen(cache->path)+strlen(key)+strlen(suffix)+2);
+    if(path == NULL) return NULL;
+
+    sprintf(path, "%s/%s%s", cache->path, key, suffix);
+
+    return path;
+}
+
+int ph_cache_load(PHCache *cache, char *key, PHBuffer *buffer) {
+    char *path;
+    FILE *fp;
+    PHInput input;
+
+    path = ph_cache_path(cache, key, ".obj");
+    if(path == NULL) return 1;
+
+    fp = fopen(path, "rb");
+    free(path);
+    if(fp == NULL) return 1;
+
+    if(ph_input_open(&input, fp)){
+        fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+
+    if(ph_buffer_init(buffer, input.size ? input.size : 1)){
+        ph_input_close(&input);
+        return 1;
+    }
+    if(ph_buffer_write(buffer, (unsigned char*)input.data, input.size)){
+        ph_buffer_free(buffer);
+        ph_input_close(&input);
+        return 1;
+    }
+
+    ph_input_close(&input);
+
+    return 0;
+}
+
+int ph_cache_store(PHCache *cache, char *key, size_t id, PHBuffer *buffer) {
+    char suffix[64];
+    char *tmp_path;
+    char *path;
+    FILE *fp;
+    int rc = 0;
+
+    /* Write to a temporary file first, so that concurrent builds never see
+     * a partially written entry */
+    sprintf(suffix, ".%lu.%lu.tmp", (unsigned long int)getpid(),
+            (unsigned long int)id);
+
+    tmp_path = ph_cache_path(cache, key, suffix);
+    if(tmp_path == NULL) return 1;
+    path = ph_cache_path(cache, key, ".obj");
+    if(path == NULL){
+        free(tmp_path);
+        return 1;
+    }
+
+    fp = fopen(tmp_path, "wb");
+    if(fp == NULL){
+        rc = 1;
+    }else{
+        if(fwrite(buffer->data, 1, buffer->size, fp) != buffer->size){
+            rc = 1;
+        }
+        if(fclose(fp)) rc = 1;
+
+        if(rc || rename(tmp_path, path)){
+            remove(tmp_path);
+            rc = 1;
+        }
+    }
+
+    free(tmp_path);
+    free(path);
+
+    return rc;
+}
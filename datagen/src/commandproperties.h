@@ -38,22 +38,18 @@
 
 #include <stddef.h>
 
-typedef struct {
-    unsigned char id;
-    size_t str_id;
-    size_t offset;
-} PHLabelCommand;
+#include <hash.h>
 
+/* A token of the converted text. It points into the input when possible, so it
+ * isn't NUL-terminated. */
 typedef struct {
-    /* Converter related stuff */
-    /* TODO: Speed up searching with hashes. */
-    int (**fncs)(void *_conv, size_t argc, char **argv);
-    char **names;
-    size_t count;
+    const char *str;
+    size_t len;
+} PHSlice;
 
-    /* Linker related stuff */
-    PHLabelCommand *labelcmds;
-    size_t labelcmd_count;
+typedef struct {
+    int (**fncs)(void *_conv, size_t argc, PHSlice *argv);
+    const PHHash *names;
 } PHCommands;
 
 #endif
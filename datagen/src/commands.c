@@ -36,32 +36,53 @@
 #include <commands.h>
 
 #include <string.h>
-#include <stdlib.h>
 
 #include <conv.h>
+#include <object.h>
 
-static unsigned long int atoi32(char *str) {
+#include <commandhash.h>
+
+static unsigned long int atoi32(PHSlice str) {
     size_t i = 0;
     unsigned long int n = 0;
 
-    if(str[0] == '-') i = 1;
+    if(str.len && str.str[0] == '-') i = 1;
 
-    for(;str[i];i++){
-        if(str[i] >= '0' && str[i] <= '9'){
+    for(;i<str.len;i++){
+        if(str.str[i] >= '0' && str.str[i] <= '9'){
             n *= 10;
-            n += str[i]-'0';
+            n += str.str[i]-'0';
         }
     }
 
-    if(str[0] == '-') n = (~n)+1;
+    if(str.len && str.str[0] == '-') n = (~n)+1;
 
     return n&0xFFFFFFFF;
 }
 
-/* TODO: Speed up string comparisons with hashes. */
+static int streq(PHSlice str, char *cstr) {
+    return strlen(cstr) == str.len && !memcmp(str.str, cstr, str.len);
+}
+
+static int putref(PHConv *conv, PHSlice label) {
+    /* The linker inserts the offset to the label here */
+    if(ph_obj_add_reloc(&conv->obj, PH_RELOC_LABEL, label.str, label.len,
+                        conv->buffer.size)){
+        return PH_CONV_E_INTERNAL;
+    }
+
+    return PH_CONV_SUCCESS;
+}
+
+static void putstr(PHConv *conv, PHSlice str) {
+    /* Tokens are stored NUL-terminated in the object files */
+    ph_buffer_write(&conv->buffer, (unsigned char*)str.str, str.len);
+    ph_buffer_putc(&conv->buffer, 0);
+}
+
 /* FIXME: Show errors when int arguments are out of range. */
 
-static int startverbatim(void *_conv, size_t argc, char **argv) {
+static int startverbatim(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
 
@@ -74,7 +95,7 @@ static int startverbatim(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int endverbatim(void *_conv, size_t argc, char **argv) {
+static int endverbatim(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
 
@@ -89,7 +110,7 @@ static int endverbatim(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int clear(void *_conv, size_t argc, char **argv) {
+static int clear(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
@@ -101,7 +122,7 @@ static int clear(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int halign(void *_conv, size_t argc, char **argv) {
+static int halign(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc < 2) return PH_CONV_E_TOO_FEW_ARGS;
@@ -109,11 +130,11 @@ static int halign(void *_conv, size_t argc, char **argv) {
 
     ph_buffer_putc(&conv->buffer, PH_CMD_HALIGN);
 
-    if(!strcmp(argv[1], "left")){
+    if(streq(argv[1], "left")){
         ph_buffer_putc(&conv->buffer, PH_CMD_ALIGN_LEFT);
-    }else if(!strcmp(argv[1], "center")){
+    }else if(streq(argv[1], "center")){
         ph_buffer_putc(&conv->buffer, PH_CMD_ALIGN_CENTER);
-    }else if(!strcmp(argv[1], "right")){
+    }else if(streq(argv[1], "right")){
         ph_buffer_putc(&conv->buffer, PH_CMD_ALIGN_RIGHT);
     }else{
         return PH_CONV_E_INCORRECT_ARGS;
@@ -122,7 +143,7 @@ static int halign(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int valign(void *_conv, size_t argc, char **argv) {
+static int valign(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc < 2) return PH_CONV_E_TOO_FEW_ARGS;
@@ -130,11 +151,11 @@ static int valign(void *_conv, size_t argc, char **argv) {
 
     ph_buffer_putc(&conv->buffer, PH_CMD_VALIGN);
 
-    if(!strcmp(argv[1], "top")){
+    if(streq(argv[1], "top")){
         ph_buffer_putc(&conv->buffer, PH_CMD_ALIGN_TOP);
-    }else if(!strcmp(argv[1], "center")){
+    }else if(streq(argv[1], "center")){
         ph_buffer_putc(&conv->buffer, PH_CMD_ALIGN_CENTER);
-    }else if(!strcmp(argv[1], "bottom")){
+    }else if(streq(argv[1], "bottom")){
         ph_buffer_putc(&conv->buffer, PH_CMD_ALIGN_BOTTOM);
     }else{
         return PH_CONV_E_INCORRECT_ARGS;
@@ -144,7 +165,7 @@ static int valign(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int setx(void *_conv, size_t argc, char **argv) {
+static int setx(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     unsigned short int x;
 
@@ -161,7 +182,7 @@ static int setx(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int sety(void *_conv, size_t argc, char **argv) {
+static int sety(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     unsigned short int y;
 
@@ -178,7 +199,7 @@ static int sety(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int pagebreak(void *_conv, size_t argc, char **argv) {
+static int pagebreak(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
@@ -190,58 +211,62 @@ static int pagebreak(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int label(void *_conv, size_t argc, char **argv) {
+static int label(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc < 2) return PH_CONV_E_TOO_FEW_ARGS;
     if(argc > 2) return PH_CONV_E_TOO_MANY_ARGS;
 
-    ph_buffer_putc(&conv->buffer, PH_CMD_LABEL);
-    ph_buffer_puts(&conv->buffer, (unsigned char*)argv[1]);
-    ph_buffer_putc(&conv->buffer, 0);
+    if(ph_obj_add_label(&conv->obj, argv[1].str, argv[1].len,
+                        conv->buffer.size,
+                        conv->jump_end != conv->buffer.size ?
+                        PH_OBJ_FALLTHROUGH : 0)){
+        return PH_CONV_E_INTERNAL;
+    }
+
+    /* The next labels at the same place can be reached from this one */
+    conv->jump_end = (size_t)-1;
 
     return PH_CONV_SUCCESS;
 }
 
-static int goto_cmd(void *_conv, size_t argc, char **argv) {
+static int goto_cmd(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc < 2) return PH_CONV_E_TOO_FEW_ARGS;
     if(argc > 2) return PH_CONV_E_TOO_MANY_ARGS;
 
     ph_buffer_putc(&conv->buffer, PH_CMD_GOTO);
-    ph_buffer_write(&conv->buffer, (unsigned char*)argv[1], strlen(argv[1])+1);
+    conv->jump_end = conv->buffer.size;
 
-    return PH_CONV_SUCCESS;
+    return putref(conv, argv[1]);
 }
 
-static int case_cmd(void *_conv, size_t argc, char **argv) {
+static int case_cmd(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc < 3) return PH_CONV_E_TOO_FEW_ARGS;
     if(argc > 3) return PH_CONV_E_TOO_MANY_ARGS;
 
     ph_buffer_putc(&conv->buffer, PH_CMD_CASE);
-    ph_buffer_write(&conv->buffer, (unsigned char*)argv[1], strlen(argv[1])+1);
-    ph_buffer_write(&conv->buffer, (unsigned char*)argv[2], strlen(argv[2])+1);
+    putstr(conv, argv[1]);
 
-    return PH_CONV_SUCCESS;
+    return putref(conv, argv[2]);
 }
 
-static int dcase(void *_conv, size_t argc, char **argv) {
+static int dcase(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc < 3) return PH_CONV_E_TOO_FEW_ARGS;
     if(argc > 3) return PH_CONV_E_TOO_MANY_ARGS;
 
     ph_buffer_putc(&conv->buffer, PH_CMD_DCASE);
-    ph_buffer_write(&conv->buffer, (unsigned char*)argv[1], strlen(argv[1])+1);
-    ph_buffer_write(&conv->buffer, (unsigned char*)argv[2], strlen(argv[2])+1);
+    putstr(conv, argv[1]);
 
-    return PH_CONV_SUCCESS;
+    return putref(conv, argv[2]);
 }
 
-static int clearcases(void *_conv, size_t argc, char **argv) {
+static int clearcases(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
@@ -253,7 +278,7 @@ static int clearcases(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int ask(void *_conv, size_t argc, char **argv) {
+static int ask(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
@@ -261,11 +286,12 @@ static int ask(void *_conv, size_t argc, char **argv) {
     (void)argv;
 
     ph_buffer_putc(&conv->buffer, PH_CMD_ASK);
+    conv->jump_end = conv->buffer.size;
 
     return PH_CONV_SUCCESS;
 }
 
-static int askc(void *_conv, size_t argc, char **argv) {
+static int askc(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
@@ -273,11 +299,12 @@ static int askc(void *_conv, size_t argc, char **argv) {
     (void)argv;
 
     ph_buffer_putc(&conv->buffer, PH_CMD_ASKC);
+    conv->jump_end = conv->buffer.size;
 
     return PH_CONV_SUCCESS;
 }
 
-static int delay(void *_conv, size_t argc, char **argv) {
+static int delay(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     unsigned short int d;
 
@@ -296,7 +323,7 @@ static int delay(void *_conv, size_t argc, char **argv) {
 
 #define PH_CMD_SEMITONES 12
 
-static int note(void *_conv, size_t argc, char **argv) {
+static int note(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     static const char *const semitones[PH_CMD_SEMITONES] = {
         "C-",
@@ -325,15 +352,15 @@ static int note(void *_conv, size_t argc, char **argv) {
     if(argc < 3) return PH_CONV_E_TOO_FEW_ARGS;
     if(argc > 3) return PH_CONV_E_TOO_MANY_ARGS;
 
-    if(strlen(argv[1]) != 3) return PH_CONV_E_INCORRECT_ARGS;
+    if(argv[1].len != 3) return PH_CONV_E_INCORRECT_ARGS;
 
-    if(strcmp(argv[1], "===")){
-        if(argv[1][2] < '0' || argv[1][2] > '7'){
+    if(!streq(argv[1], "===")){
+        if(argv[1].str[2] < '0' || argv[1].str[2] > '7'){
             return PH_CONV_E_INCORRECT_ARGS;
         }
-        octave = argv[1][2]-'0';
+        octave = argv[1].str[2]-'0';
         for(i=0;i<PH_CMD_SEMITONES;i++){
-            if(!memcmp(argv[1], semitones[i], 2)){
+            if(!memcmp(argv[1].str, semitones[i], 2)){
                 semitone = i;
                 break;
             }
@@ -345,7 +372,7 @@ static int note(void *_conv, size_t argc, char **argv) {
         note = 0x80;
     }
 
-    duration = atoi(argv[2]);
+    duration = atoi32(argv[2]);
 
     ph_buffer_putc(&conv->buffer, PH_CMD_NOTE);
     ph_buffer_putc(&conv->buffer, note);
@@ -355,7 +382,7 @@ static int note(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int startbgm(void *_conv, size_t argc, char **argv) {
+static int startbgm(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
@@ -368,7 +395,7 @@ static int startbgm(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int endbgm(void *_conv, size_t argc, char **argv) {
+static int endbgm(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
@@ -381,17 +408,8 @@ static int endbgm(void *_conv, size_t argc, char **argv) {
     return PH_CONV_SUCCESS;
 }
 
-static int var(void *_conv, size_t argc, char **argv) {
+static int var(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
-
-    /* These value map to the PH_CMD_VAR_* enumeration constants */
-    static const char *const subcmds[] = {
-        "set",
-        "load",
-        "store",
-        "del",
-        NULL
-    };
     size_t i;
 
     if(conv->verbatim) return PH_CONV_SUCCESS;
@@ -399,52 +417,34 @@ static int var(void *_conv, size_t argc, char **argv) {
 
     ph_buffer_putc(&conv->buffer, PH_CMD_VAR);
 
-    for(i=0;subcmds[i] != NULL;i++){
-        if(!strcmp(argv[1], subcmds[i])){
-            break;
-        }
-    }
-    if(subcmds[i] == NULL) return PH_CONV_E_INCORRECT_ARGS;
+    i = ph_hash_find(&ph_hash_var, argv[1].str, argv[1].len);
+    if(i >= ph_hash_var.count) return PH_CONV_E_INCORRECT_ARGS;
     ph_buffer_putc(&conv->buffer, i);
 
     if(i == PH_CMD_VAR_SET){
         long unsigned int n;
 
-        if(argc < 4) return PH_CONV_E_TOO_MANY_ARGS;
+        if(argc < 4) return PH_CONV_E_TOO_FEW_ARGS;
         if(argc > 4) return PH_CONV_E_TOO_MANY_ARGS;
 
         n = atoi32(argv[3]);
 
         ph_buffer_putc(&conv->buffer, n&0xFF);
-        ph_buffer_putc(&conv->buffer, (n&0xFF)<<8);
-        ph_buffer_putc(&conv->buffer, (n&0xFF)<<16);
-        ph_buffer_putc(&conv->buffer, (n&0xFF)<<24);
+        ph_buffer_putc(&conv->buffer, (n>>8)&0xFF);
+        ph_buffer_putc(&conv->buffer, (n>>16)&0xFF);
+        ph_buffer_putc(&conv->buffer, (n>>24)&0xFF);
     }else if(argc > 3){
         return PH_CONV_E_TOO_MANY_ARGS;
     }
 
-    ph_buffer_write(&conv->buffer, (unsigned char*)argv[2], strlen(argv[2])+1);
+    /* The linker replaces the name by the slot of the variable */
+    putstr(conv, argv[2]);
 
     return PH_CONV_SUCCESS;
 }
 
-static int math(void *_conv, size_t argc, char **argv) {
+static int math(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
-
-    /* These value map to the PH_CMD_VAR_* enumeration constants */
-    static const char *const subcmds[] = {
-        "add",
-        "sub",
-        "mul",
-        "div",
-        "mod",
-        "lsl",
-        "lsr",
-        "and",
-        "or",
-        "xor",
-        NULL
-    };
     size_t i;
 
     if(conv->verbatim) return PH_CONV_SUCCESS;
@@ -453,31 +453,15 @@ static int math(void *_conv, size_t argc, char **argv) {
 
     ph_buffer_putc(&conv->buffer, PH_CMD_MATH);
 
-    for(i=0;subcmds[i] != NULL;i++){
-        if(!strcmp(argv[1], subcmds[i])){
-            break;
-        }
-    }
-    if(subcmds[i] == NULL) return PH_CONV_E_INCORRECT_ARGS;
+    i = ph_hash_find(&ph_hash_math, argv[1].str, argv[1].len);
+    if(i >= ph_hash_math.count) return PH_CONV_E_INCORRECT_ARGS;
     ph_buffer_putc(&conv->buffer, i);
 
     return PH_CONV_SUCCESS;
 }
 
-static int tmp(void *_conv, size_t argc, char **argv) {
+static int tmp(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
-
-    /* These value map to the PH_CMD_TMP_* enumeration constants */
-    static const char *const subcmds[] = {
-        "push",
-        "pull",
-        "load",
-        "use",
-        "get",
-        "setsp",
-        "getsp",
-        NULL
-    };
     size_t i;
 
     if(conv->verbatim) return PH_CONV_SUCCESS;
@@ -486,34 +470,15 @@ static int tmp(void *_conv, size_t argc, char **argv) {
 
     ph_buffer_putc(&conv->buffer, PH_CMD_TMPOP);
 
-    for(i=0;subcmds[i] != NULL;i++){
-        if(!strcmp(argv[1], subcmds[i])){
-            break;
-        }
-    }
-    if(subcmds[i] == NULL) return PH_CONV_E_INCORRECT_ARGS;
+    i = ph_hash_find(&ph_hash_tmp, argv[1].str, argv[1].len);
+    if(i >= ph_hash_tmp.count) return PH_CONV_E_INCORRECT_ARGS;
     ph_buffer_putc(&conv->buffer, i);
 
     return PH_CONV_SUCCESS;
 }
 
-static int branch(void *_conv, size_t argc, char **argv) {
+static int branch(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
-
-    /* These value map to the PH_CMD_BRANCH_* enumeration constants */
-    static const char *const subcmds[] = {
-        "eq",
-        "ne",
-        "lt",
-        "le",
-        "gt",
-        "ge",
-        "ult",
-        "ule",
-        "ugt",
-        "uge",
-        NULL
-    };
     size_t i;
 
     if(conv->verbatim) return PH_CONV_SUCCESS;
@@ -522,35 +487,15 @@ static int branch(void *_conv, size_t argc, char **argv) {
 
     ph_buffer_putc(&conv->buffer, PH_CMD_BRANCH);
 
-    for(i=0;subcmds[i] != NULL;i++){
-        if(!strcmp(argv[1], subcmds[i])){
-            break;
-        }
-    }
-    if(subcmds[i] == NULL) return PH_CONV_E_INCORRECT_ARGS;
+    i = ph_hash_find(&ph_hash_branch, argv[1].str, argv[1].len);
+    if(i >= ph_hash_branch.count) return PH_CONV_E_INCORRECT_ARGS;
     ph_buffer_putc(&conv->buffer, i);
 
-    ph_buffer_write(&conv->buffer, (unsigned char*)argv[2], strlen(argv[2])+1);
-
-    return PH_CONV_SUCCESS;
+    return putref(conv, argv[2]);
 }
 
-static int io(void *_conv, size_t argc, char **argv) {
+static int io(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
-
-    /* These value map to the PH_CMD_VAR_* enumeration constants */
-    static const char *const subcmds[] = {
-        "putint",
-        "putc",
-        "input",
-        "setx",
-        "sety",
-        "getx",
-        "gety",
-        "note",
-        "time",
-        NULL
-    };
     size_t i;
 
     if(conv->verbatim) return PH_CONV_SUCCESS;
@@ -559,18 +504,14 @@ static int io(void *_conv, size_t argc, char **argv) {
 
     ph_buffer_putc(&conv->buffer, PH_CMD_IOOP);
 
-    for(i=0;subcmds[i] != NULL;i++){
-        if(!strcmp(argv[1], subcmds[i])){
-            break;
-        }
-    }
-    if(subcmds[i] == NULL) return PH_CONV_E_INCORRECT_ARGS;
+    i = ph_hash_find(&ph_hash_io, argv[1].str, argv[1].len);
+    if(i >= ph_hash_io.count) return PH_CONV_E_INCORRECT_ARGS;
     ph_buffer_putc(&conv->buffer, i);
 
     return PH_CONV_SUCCESS;
 }
 
-static int return_cmd(void *_conv, size_t argc, char **argv) {
+static int return_cmd(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
     if(conv->verbatim) return PH_CONV_SUCCESS;
     if(argc > 1) return PH_CONV_E_TOO_MANY_ARGS;
@@ -579,17 +520,13 @@ static int return_cmd(void *_conv, size_t argc, char **argv) {
     (void)argv;
 
     ph_buffer_putc(&conv->buffer, PH_CMD_RETURN);
+    conv->jump_end = conv->buffer.size;
 
     return PH_CONV_SUCCESS;
 }
 
-static int ext(void *_conv, size_t argc, char **argv) {
+static int ext(void *_conv, size_t argc, PHSlice *argv) {
     PHConv *conv = _conv;
-
-    static const char *const subcmds[] = {
-        /* TODO */
-        NULL
-    };
     size_t i;
 
     if(conv->verbatim) return PH_CONV_SUCCESS;
@@ -598,93 +535,20 @@ static int ext(void *_conv, size_t argc, char **argv) {
 
     ph_buffer_putc(&conv->buffer, PH_CMD_EXTENDED);
 
-    for(i=0;subcmds[i] != NULL;i++){
-        if(!strcmp(argv[1], subcmds[i])){
-            break;
-        }
-    }
-    if(subcmds[i] == NULL) return PH_CONV_E_INCORRECT_ARGS;
+    i = ph_hash_find(&ph_hash_ext, argv[1].str, argv[1].len);
+    if(i >= ph_hash_ext.count) return PH_CONV_E_INCORRECT_ARGS;
     ph_buffer_putc(&conv->buffer, i);
 
     return PH_CONV_SUCCESS;
 }
 
-static int (*fncs[])(void *_conv, size_t argc, char **argv) = {
-    startverbatim,
-    endverbatim,
-    clear,
-    halign,
-    valign,
-    setx,
-    sety,
-    pagebreak,
-    label,
-    goto_cmd,
-    case_cmd,
-    dcase,
-    clearcases,
-    ask,
-    askc,
-    delay,
-    note,
-    startbgm,
-    endbgm,
-
-    var,
-    math,
-    tmp,
-    branch,
-    io,
-
-    return_cmd,
-
-    ext
-};
-
-static char *names[] = {
-    "startverbatim",
-    "endverbatim",
-    "clear",
-    "halign",
-    "valign",
-    "setx",
-    "sety",
-    "pagebreak",
-    "label",
-    "goto",
-    "case",
-    "dcase", /* Displayed case */
-    "clearcases", /* Clear the case list */
-    "ask",
-    "askc", /* Ask and clear case list */
-    "delay",
-    "note",
-    "startbgm", /* Start background music */
-    "endbgm", /* End background music */
-
-    /* Arithmetic commands */
-    "var",
-    "math",
-    "tmp",
-    "branch",
-    "io",
-
-    "return",
-
-    "ext"
-};
+#define _FNC(name, fnc, id, ops) fnc,
 
-static PHLabelCommand labelcmds[PH_LABELCMD_AMOUNT] = {
-    {PH_CMD_GOTO, 0, 0},
-    {PH_CMD_CASE, 1, 0},
-    {PH_CMD_DCASE, 1, 0},
-    {PH_CMD_BRANCH, 2, 1}
+static int (*fncs[])(void *_conv, size_t argc, PHSlice *argv) = {
+    PH_CMD_TABLE(_FNC)
 };
 
 PHCommands ph_commands = {
     fncs,
-    names,
-    PH_CMD_AMOUNT,
-    labelcmds,
-    PH_LABELCMD_AMOUNT
+    &ph_hash_cmd
 };
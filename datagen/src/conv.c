@@ -40,19 +40,46 @@
 
 #include <format.h>
 
+#include <input.h>
+#include <scan.h>
+
 int ph_conv_init(PHConv *conv, PHCommands *commands, void *extra) {
     conv->verbatim = 0;
+    conv->bulk = 1;
 
     conv->commands = commands;
 
     conv->extra = extra;
 
     if(ph_buffer_init(&conv->buffer, 64)) return 1;
+    if(ph_obj_writer_init(&conv->obj)){
+        ph_buffer_free(&conv->buffer);
+        return 1;
+    }
 
     return 0;
 }
 
 int ph_conv_convert(PHConv *conv, FILE *in) {
+    PHInput input;
+
+    if(ph_input_open(&input, in)){
+        conv->line = 0;
+        conv->error = PH_CONV_E_READ;
+
+        return conv->error;
+    }
+
+    ph_conv_convert_mem(conv, input.data, input.size);
+
+    ph_input_close(&input);
+
+    return conv->error;
+}
+
+int ph_conv_convert_mem(PHConv *conv, const unsigned char *data,
+                        size_t size) {
+    size_t n;
     unsigned char r;
     unsigned long c;
 
@@ -69,25 +96,31 @@ int ph_conv_convert(PHConv *conv, FILE *in) {
 
     char *ifs = " \t\n#";
 
+    /* Tokens are slices of the input as long as they are made of contiguous
+     * single byte chars. Only tokens containing escapes, CRs or multibyte
+     * chars are copied to token, and then to cmd. */
+    const char *token_ptr = NULL;
+    unsigned char token_copy = 0;
     char token[PH_CONV_TOKEN_MAX];
-    char cmd[PH_CONV_CMD_MAX_TOKENS][PH_CONV_TOKEN_MAX+1];
-    char *argv[PH_CONV_CMD_MAX_TOKENS];
+    char cmd[PH_CONV_CMD_MAX_TOKENS][PH_CONV_TOKEN_MAX];
+    PHSlice argv[PH_CONV_CMD_MAX_TOKENS];
     size_t token_len = 0;
     size_t command_tok = 0;
 
     size_t newlines = 0;
 
-    { /* TODO: Avoid having this messy array of pointers */
-        size_t i;
-        for(i=0;i<PH_CONV_CMD_MAX_TOKENS;i++){
-            argv[i] = cmd[i];
-        }
-    }
-
     conv->line = 1;
     conv->error = PH_CONV_SUCCESS;
 
-    while(fread(&r, 1, 1, in) == 1){
+    conv->verbatim = 0;
+    /* Labels at the start of the file can be reached from the previous file */
+    conv->jump_end = (size_t)-1;
+    ph_buffer_truncate(&conv->buffer, 0);
+    ph_obj_writer_reset(&conv->obj);
+
+    for(n=0;n<size;n++){
+        r = data[n];
+
         /* Parse UTF-8 sequences */
 
         byte_count++;
@@ -154,7 +187,19 @@ int ph_conv_convert(PHConv *conv, FILE *in) {
             /* Add char to token */
 
             if(token_len < PH_CONV_TOKEN_MAX-1){
-                token[token_len++] = c;
+                if(!token_len){
+                    token_ptr = (const char*)data+n;
+                    token_copy = 0;
+                }
+                if(!token_copy && (c != r ||
+                   token_ptr+token_len != (const char*)data+n)){
+                    /* The token isn't a slice of the input anymore */
+                    memcpy(token, token_ptr, token_len);
+                    token_ptr = token;
+                    token_copy = 1;
+                }
+                if(token_copy) token[token_len] = c;
+                token_len++;
             }else if(command && !conv->verbatim){
                 conv->error = PH_CONV_E_TOKEN_TOO_LONG;
                 break;
@@ -179,8 +224,13 @@ int ph_conv_convert(PHConv *conv, FILE *in) {
                 /* Token done */
 
                 if(command_tok < PH_CONV_CMD_MAX_TOKENS-1){
-                    memcpy(cmd[command_tok], token, token_len);
-                    cmd[command_tok][token_len] = 0;
+                    if(token_copy){
+                        memcpy(cmd[command_tok], token, token_len);
+                        argv[command_tok].str = cmd[command_tok];
+                    }else{
+                        argv[command_tok].str = token_ptr;
+                    }
+                    argv[command_tok].len = token_len;
                     command_tok++;
                 }else if(!conv->verbatim){
                     conv->error = PH_CONV_E_CMD_TOO_LONG;
@@ -207,13 +257,9 @@ int ph_conv_convert(PHConv *conv, FILE *in) {
 
                 size_t i;
 
-                for(i=0;i<conv->commands->count;i++){
-                    if(!strcmp((char*)conv->commands->names[i],
-                               (char*)cmd[0])){
-                        break;
-                    }
-                }
-                if(i >= conv->commands->count){
+                i = ph_hash_find(conv->commands->names, argv[0].str,
+                                 argv[0].len);
+                if(i >= conv->commands->names->count){
                     conv->error = PH_CONV_E_CMD_MISSING;
                     break;
                 }
@@ -227,6 +273,55 @@ int ph_conv_convert(PHConv *conv, FILE *in) {
         }
 
         escaped = 0;
+
+        if(conv->bulk && c > ' ' && c < 0x7F && c != '#' && c != '\\'){
+            /* The following plain chars would all go through the same path
+             * as this one: copy them to the output and to the token at
+             * once. */
+            size_t run = ph_scan_plain(data+n+1, size-n-1);
+
+            if(run){
+                size_t left = PH_CONV_TOKEN_MAX-1-token_len;
+
+                if(!command || conv->verbatim){
+                    ph_buffer_write(&conv->buffer, (unsigned char*)data+n+1,
+                                    run);
+                }
+
+                if(run > left){
+                    if(command && !conv->verbatim){
+                        conv->error = PH_CONV_E_TOKEN_TOO_LONG;
+                        break;
+                    }
+                }else{
+                    left = run;
+                }
+                /* If the token is still a slice of the input, the run is
+                 * right after its end. */
+                if(token_copy) memcpy(token+token_len, data+n+1, left);
+                token_len += left;
+
+                n += run;
+            }
+        }
+    }
+
+    if(!conv->error){
+        /* Put the header and the tables before the payload */
+        PHBuffer object;
+
+        if(ph_buffer_init(&object, 64)){
+            conv->error = PH_CONV_E_INTERNAL;
+        }else if(ph_obj_write(&conv->obj, conv->buffer.data,
+                              conv->buffer.size,
+                              conv->jump_end != conv->buffer.size ?
+                              PH_OBJ_FALLTHROUGH : 0, &object)){
+            ph_buffer_free(&object);
+            conv->error = PH_CONV_E_INTERNAL;
+        }else{
+            ph_buffer_free(&conv->buffer);
+            conv->buffer = object;
+        }
     }
 
     return conv->error;
@@ -235,6 +330,8 @@ int ph_conv_convert(PHConv *conv, FILE *in) {
 char *ph_conv_get_error(PHConv *conv) {
     static char *errors[PH_CONV_E_AMOUNT] = {
         "Success",
+        "Internal error",
+        "Read error",
         "Unsupported char",
         "Command token too long",
         "Command too long",
@@ -249,4 +346,5 @@ char *ph_conv_get_error(PHConv *conv) {
 
 void ph_conv_free(PHConv *conv) {
     ph_buffer_free(&conv->buffer);
+    ph_obj_writer_free(&conv->obj);
 }
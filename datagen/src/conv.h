@@ -39,18 +39,27 @@
 #include <stdio.h>
 #include <arena.h>
 #include <buffer.h>
+#include <object.h>
 
 #include <commandproperties.h>
 
 typedef struct {
     unsigned char verbatim;
 
+    /* Copy runs of plain ASCII chars in bulk instead of handling each char
+     * separately. The output is the same in both cases. */
+    unsigned char bulk;
+
     size_t cmd_start;
+    /* End of the last goto, ask or return, that the engine can't run past */
+    size_t jump_end;
 
     size_t line;
     int error;
 
+    /* The payload while converting, the whole object file once done */
     PHBuffer buffer;
+    PHObjWriter obj;
 
     PHCommands *commands;
     void *extra;
@@ -59,6 +68,9 @@ typedef struct {
 enum {
     PH_CONV_SUCCESS,
 
+    PH_CONV_E_INTERNAL,
+    PH_CONV_E_READ,
+
     PH_CONV_E_UNSUPPORTED_CHAR,
     PH_CONV_E_TOKEN_TOO_LONG,
     PH_CONV_E_CMD_TOO_LONG,
@@ -72,6 +84,8 @@ enum {
 
 int ph_conv_init(PHConv *conv, PHCommands *commands, void *extra);
 int ph_conv_convert(PHConv *conv, FILE *in);
+int ph_conv_convert_mem(PHConv *conv, const unsigned char *data,
+                        size_t size);
 char *ph_conv_get_error(PHConv *conv);
 void ph_conv_free(PHConv *conv);
 
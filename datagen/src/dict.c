@@ -0,0 +1,357 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dict.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <hash.h>
+
+/* Symbols of the sample are chars, or entries merged while building the
+ * dictionary if they are above 255. The runs are separated by
+ * PH_DICT_NONE. */
+#define PH_DICT_NONE (-1)
+
+typedef struct {
+    /* First and second symbol plus one, 0 if the slot is empty */
+    unsigned long int key;
+    size_t count;
+} PHDictPair;
+
+typedef struct {
+    int left;
+    int right;
+    size_t len;
+    size_t uses;
+} PHDictMerge;
+
+int ph_dict_init(PHDict *dict) {
+    size_t i;
+
+    if(ph_buffer_init(&dict->text, 64)) return 1;
+    if(ph_buffer_init(&dict->sample, 1024)){
+        ph_buffer_free(&dict->text);
+        return 1;
+    }
+
+    dict->count = 0;
+    for(i=0;i<256;i++) dict->first[i] = -1;
+
+    dict->cost = NULL;
+    dict->choice = NULL;
+    dict->scratch_size = 0;
+
+    return 0;
+}
+
+int ph_dict_sample(PHDict *dict, const unsigned char *text, size_t size) {
+    size_t left;
+
+    if(dict->sample.size >= PH_DICT_SAMPLE_MAX) return 0;
+
+    left = PH_DICT_SAMPLE_MAX-dict->sample.size;
+    if(size > left) size = left;
+
+    if(ph_buffer_write(&dict->sample, (unsigned char*)text, size)) return 1;
+
+    return ph_buffer_putc(&dict->sample, 0);
+}
+
+static size_t ph_dict_len(PHDictMerge *merges, int symbol) {
+    return symbol < 256 ? 1 : merges[symbol-256].len;
+}
+
+/* Appends the text of a symbol to the entry text */
+static int ph_dict_expand(PHDict *dict, PHDictMerge *merges, int symbol) {
+    if(symbol < 256) return ph_buffer_putc(&dict->text, symbol);
+
+    return ph_dict_expand(dict, merges, merges[symbol-256].left) ||
+           ph_dict_expand(dict, merges, merges[symbol-256].right);
+}
+
+/* Counts the pairs of symbols, puts the merge that saves the most bytes in
+ * best and returns the number of bytes it saves. */
+static long int ph_dict_best(PHDictPair *pairs, unsigned char bits,
+                             int *symbols, size_t count, PHDictMerge *merges,
+                             PHDictMerge *best) {
+    size_t mask = ((size_t)1<<bits)-1;
+    long int best_gain = 0;
+    size_t i;
+
+    memset(pairs, 0, sizeof(PHDictPair)<<bits);
+
+    for(i=0;i+1<count;i++){
+        int a = symbols[i];
+        int b = symbols[i+1];
+        unsigned long int key;
+        size_t n;
+
+        if(a == PH_DICT_NONE || b == PH_DICT_NONE) continue;
+        if(ph_dict_len(merges, a)+ph_dict_len(merges, b) > PH_DICT_ENTRY_MAX){
+            continue;
+        }
+
+        key = ((unsigned long int)a<<16|b)+1;
+        for(n=ph_hash_slot(key, bits);pairs[n].key && pairs[n].key != key;
+            n=(n+1)&mask);
+
+        pairs[n].key = key;
+        pairs[n].count++;
+    }
+
+    for(i=0;i<=mask;i++){
+        PHDictMerge merge;
+        long int gain;
+
+        if(!pairs[i].key) continue;
+
+        merge.left = (pairs[i].key-1)>>16;
+        merge.right = (pairs[i].key-1)&0xFFFF;
+        merge.len = ph_dict_len(merges, merge.left)+
+                    ph_dict_len(merges, merge.right);
+
+        /* Each use of the entry saves all its chars but one, and the entry
+         * takes its chars and its end in the dictionary */
+        gain = (long int)pairs[i].count*(merge.len-1)-(merge.len+2);
+        if(gain > best_gain || (gain == best_gain && gain > 0 &&
+           (merge.left < best->left ||
+            (merge.left == best->left && merge.right < best->right)))){
+            best_gain = gain;
+            *best = merge;
+        }
+    }
+
+    return best_gain;
+}
+
+/* The temporary arrays are allocated in scratch, and freed before
+ * returning */
+int ph_dict_build(PHDict *dict, PHArena *scratch) {
+    PHDictMerge merges[PH_DICT_MAX];
+    size_t order[PH_DICT_MAX];
+    size_t merge_count = 0;
+    PHDictPair *pairs;
+    PHArenaMark mark;
+    unsigned char bits;
+    int *symbols;
+    size_t count = dict->sample.size;
+    size_t i, n;
+
+    dict->count = 0;
+    ph_buffer_truncate(&dict->text, 0);
+    for(i=0;i<256;i++) dict->first[i] = -1;
+
+    if(!count) return 0;
+
+    ph_arena_mark(scratch, &mark);
+
+    for(bits=4;((size_t)1<<bits) < count*2;bits++);
+    symbols = ph_arena_alloc(scratch, sizeof(int), count);
+    pairs = ph_arena_alloc(scratch, sizeof(PHDictPair), (size_t)1<<bits);
+    if(symbols == NULL || pairs == NULL){
+        ph_arena_rollback(scratch, &mark);
+        return 1;
+    }
+
+    for(i=0;i<count;i++){
+        symbols[i] = dict->sample.data[i] ? dict->sample.data[i] :
+                     PH_DICT_NONE;
+    }
+
+    /* Merge the pair that saves the most bytes until there is no room left
+     * or nothing to save */
+    while(merge_count < PH_DICT_MAX){
+        PHDictMerge *merge = merges+merge_count;
+        int symbol = 256+merge_count;
+
+        if(ph_dict_best(pairs, bits, symbols, count, merges, merge) <= 0){
+            break;
+        }
+
+        for(i=n=0;i<count;n++){
+            if(i+1 < count && symbols[i] == merge->left &&
+               symbols[i+1] == merge->right){
+                symbols[n] = symbol;
+                i += 2;
+            }else{
+                symbols[n] = symbols[i++];
+            }
+        }
+        count = n;
+
+        merge->uses = 0;
+        merge_count++;
+    }
+
+    /* Entries only used to build longer ones are dropped */
+    for(i=0;i<count;i++){
+        if(symbols[i] >= 256) merges[symbols[i]-256].uses++;
+    }
+
+    ph_arena_rollback(scratch, &mark);
+
+    /* The most used entries get the single byte codes */
+    for(i=0;i<merge_count;i++){
+        for(n=i;n && merges[order[n-1]].uses < merges[i].uses;n--){
+            order[n] = order[n-1];
+        }
+        order[n] = i;
+    }
+
+    for(i=0;i<merge_count;i++){
+        PHDictMerge *merge = merges+order[i];
+        size_t cost = dict->count < PH_DICT_SHORT ? 1 : 2;
+
+        if(merge->len <= cost ||
+           merge->uses*(merge->len-cost) <= merge->len+2){
+            continue;
+        }
+
+        if(ph_dict_expand(dict, merges, 256+order[i])) return 1;
+        dict->ends[dict->count++] = dict->text.size;
+    }
+
+    /* Look the entries up by their first char */
+    for(i=dict->count;i--;){
+        unsigned char c = dict->text.data[i ? dict->ends[i-1] : 0];
+
+        dict->next[i] = dict->first[c];
+        dict->first[c] = i;
+    }
+
+    return 0;
+}
+
+int ph_dict_compress(PHDict *dict, const unsigned char *text, size_t size,
+                     PHBuffer *out) {
+    size_t i;
+
+    if(size+1 > dict->scratch_size){
+        size_t *cost;
+        int *choice;
+
+        cost = realloc(dict->cost, (size+1)*sizeof(size_t));
+        if(cost == NULL) return 1;
+        dict->cost = cost;
+
+        choice = realloc(dict->choice, (size+1)*sizeof(int));
+        if(choice == NULL) return 1;
+        dict->choice = choice;
+
+        dict->scratch_size = size+1;
+    }
+
+    /* Find the cheapest encoding of each suffix of the text, starting with
+     * the shortest one */
+    dict->cost[size] = 0;
+    for(i=size;i--;){
+        int e;
+
+        dict->cost[i] = dict->cost[i+1]+1;
+        dict->choice[i] = -1;
+
+        for(e=dict->first[text[i]];e >= 0;e=dict->next[e]){
+            size_t start = e ? dict->ends[e-1] : 0;
+            size_t len = dict->ends[e]-start;
+            size_t cost;
+
+            if(len > size-i || memcmp(dict->text.data+start, text+i, len)){
+                continue;
+            }
+
+            cost = dict->cost[i+len]+(e < PH_DICT_SHORT ? 1 : 2);
+            if(cost < dict->cost[i]){
+                dict->cost[i] = cost;
+                dict->choice[i] = e;
+            }
+        }
+    }
+
+    for(i=0;i<size;){
+        int e = dict->choice[i];
+
+        if(e < 0){
+            if(ph_buffer_putc(out, text[i])) return 1;
+            i++;
+            continue;
+        }
+
+        if(e < PH_DICT_SHORT){
+            if(ph_buffer_putc(out, PH_DICT_CODE(e))) return 1;
+        }else{
+            if(ph_buffer_putc(out, PH_CMD_DICT) ||
+               ph_buffer_putc(out, e-PH_DICT_SHORT)){
+                return 1;
+            }
+        }
+        i += dict->ends[e]-(e ? dict->ends[e-1] : 0);
+    }
+
+    return 0;
+}
+
+size_t ph_dict_size(PHDict *dict) {
+    return 3+dict->count*2+dict->text.size;
+}
+
+int ph_dict_write(PHDict *dict, PHBuffer *out) {
+    size_t i;
+
+    if(ph_buffer_putc(out, PH_CMD_DICT) ||
+       ph_buffer_putc(out, dict->count&0xFF) ||
+       ph_buffer_putc(out, dict->count>>8)){
+        return 1;
+    }
+
+    for(i=0;i<dict->count;i++){
+        if(ph_buffer_putc(out, dict->ends[i]&0xFF) ||
+           ph_buffer_putc(out, dict->ends[i]>>8)){
+            return 1;
+        }
+    }
+
+    return ph_buffer_write(out, dict->text.data, dict->text.size);
+}
+
+void ph_dict_free(PHDict *dict) {
+    ph_buffer_free(&dict->text);
+    ph_buffer_free(&dict->sample);
+    free(dict->cost);
+    free(dict->choice);
+
+    dict->cost = NULL;
+    dict->choice = NULL;
+}
@@ -0,0 +1,95 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHOSPHOR_DICT_H
+#define PHOSPHOR_DICT_H
+
+#include <stddef.h>
+
+#include <arena.h>
+#include <buffer.h>
+
+#include <format.h>
+
+/* Dictionary used by the linker to compress the text. It is built from a
+ * sample of the text by merging the most frequent pairs of chars or entries
+ * into new entries, and the text is then split into chars and entries with
+ * as few bytes as possible. The entries are plain text, so the engine only has
+ * to copy them while printing. */
+
+/* Size of the text the dictionary is built from */
+#define PH_DICT_SAMPLE_MAX (128*1024)
+/* Longest entry */
+#define PH_DICT_ENTRY_MAX 32
+
+typedef struct {
+    /* Text of the entries and the end of each one */
+    PHBuffer text;
+    size_t ends[PH_DICT_MAX];
+    size_t count;
+
+    /* Entries starting with each char, linked through next, -1 at the end */
+    int first[256];
+    int next[PH_DICT_MAX];
+
+    /* Text runs the dictionary is built from, separated by NUL bytes */
+    PHBuffer sample;
+
+    /* Cheapest encoding of each suffix of the text being compressed */
+    size_t *cost;
+    int *choice;
+    size_t scratch_size;
+} PHDict;
+
+int ph_dict_init(PHDict *dict);
+
+/* Adds a text run to the sample. The text past PH_DICT_SAMPLE_MAX is ignored.
+ */
+int ph_dict_sample(PHDict *dict, const unsigned char *text, size_t size);
+
+int ph_dict_build(PHDict *dict, PHArena *scratch);
+
+/* Appends the compressed text to out */
+int ph_dict_compress(PHDict *dict, const unsigned char *text, size_t size,
+                     PHBuffer *out);
+
+/* Size of the dictionary at the start of the data */
+size_t ph_dict_size(PHDict *dict);
+
+int ph_dict_write(PHDict *dict, PHBuffer *out);
+
+void ph_dict_free(PHDict *dict);
+
+#endif
@@ -0,0 +1,247 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <elfobj.h>
+
+#include <string.h>
+
+#include <object.h>
+
+#define PH_ELF_HEADER_SIZE 52
+#define PH_ELF_SECTION_SIZE 40
+#define PH_ELF_SYMBOL_SIZE 16
+
+#define PH_ELF_MACHINE_RISCV 243
+
+enum {
+    PH_ELF_NULL,
+    PH_ELF_DATA,
+    PH_ELF_SYMTAB,
+    PH_ELF_STRTAB,
+    PH_ELF_SHSTRTAB,
+
+    PH_ELF_SECTION_AMOUNT
+};
+
+/* Section types */
+enum {
+    PH_ELF_SHT_NULL,
+    PH_ELF_SHT_PROGBITS,
+    PH_ELF_SHT_SYMTAB,
+    PH_ELF_SHT_STRTAB
+};
+
+/* Symbol binding and type, packed in the info byte */
+#define PH_ELF_STB_LOCAL 0
+#define PH_ELF_STB_GLOBAL 1
+#define PH_ELF_STT_OBJECT 1
+#define PH_ELF_STT_SECTION 3
+#define PH_ELF_SYMBOL_INFO(bind, type) (((bind)<<4)|(type))
+
+#define PH_ELF_SHF_ALLOC 2
+
+#define PH_ELF_ALIGN(n) (((n)+3)&~(size_t)3)
+
+static int ph_elf_put16(PHBuffer *buffer, unsigned int n) {
+    unsigned char bytes[2];
+
+    bytes[0] = n&0xFF;
+    bytes[1] = (n>>8)&0xFF;
+
+    return ph_buffer_write(buffer, bytes, 2);
+}
+
+static int ph_elf_pad(PHBuffer *buffer) {
+    while(buffer->size&3){
+        if(ph_buffer_putc(buffer, 0)) return 1;
+    }
+
+    return 0;
+}
+
+static int ph_elf_symbol(PHBuffer *buffer, size_t name, size_t value,
+                         size_t size, unsigned char info,
+                         unsigned int section) {
+    if(ph_obj_put32(buffer, name)) return 1;
+    if(ph_obj_put32(buffer, value)) return 1;
+    if(ph_obj_put32(buffer, size)) return 1;
+    if(ph_buffer_putc(buffer, info)) return 1;
+    /* Default visibility */
+    if(ph_buffer_putc(buffer, 0)) return 1;
+    if(ph_elf_put16(buffer, section)) return 1;
+
+    return 0;
+}
+
+static int ph_elf_section(PHBuffer *buffer, size_t name, unsigned int type,
+                          size_t flags, size_t offset, size_t size,
+                          size_t link, size_t info, size_t align,
+                          size_t entsize) {
+    if(ph_obj_put32(buffer, name)) return 1;
+    if(ph_obj_put32(buffer, type)) return 1;
+    if(ph_obj_put32(buffer, flags)) return 1;
+    /* Not loaded at a fixed address */
+    if(ph_obj_put32(buffer, 0)) return 1;
+    if(ph_obj_put32(buffer, offset)) return 1;
+    if(ph_obj_put32(buffer, size)) return 1;
+    if(ph_obj_put32(buffer, link)) return 1;
+    if(ph_obj_put32(buffer, info)) return 1;
+    if(ph_obj_put32(buffer, align)) return 1;
+    if(ph_obj_put32(buffer, entsize)) return 1;
+
+    return 0;
+}
+
+/* Writes a string with a prefix and a suffix to a string table */
+static int ph_elf_string(PHBuffer *buffer, const char *prefix,
+                         const char *name, const char *suffix) {
+    if(ph_buffer_write(buffer, (unsigned char*)prefix, strlen(prefix))){
+        return 1;
+    }
+    if(ph_buffer_write(buffer, (unsigned char*)name, strlen(name))) return 1;
+
+    return ph_buffer_write(buffer, (unsigned char*)suffix, strlen(suffix)+1);
+}
+
+int ph_elf_write(PHBuffer *out, const unsigned char *data, size_t size,
+                 const char *name) {
+    static const unsigned char ident[16] = {
+        0x7F, 'E', 'L', 'F',
+        /* 32 bit, little endian, version 1, System V ABI */
+        1, 1, 1, 0
+    };
+
+    size_t data_size = PH_ELF_ALIGN(size)+4;
+    size_t symtab = PH_ELF_HEADER_SIZE+data_size;
+    size_t strtab = symtab+4*PH_ELF_SYMBOL_SIZE;
+    size_t strtab_size = strlen(name)*2+sizeof("_len")+2;
+    size_t shstrtab = strtab+strtab_size;
+    size_t shstrtab_size;
+    size_t sections;
+
+    /* The section names, the first one is the data section */
+    const size_t data_name = 1;
+    const size_t symtab_name = data_name+sizeof(".rodata.")+strlen(name);
+    const size_t strtab_name = symtab_name+sizeof(".symtab");
+    const size_t shstrtab_name = strtab_name+sizeof(".strtab");
+
+    shstrtab_size = shstrtab_name+sizeof(".shstrtab");
+    sections = PH_ELF_ALIGN(shstrtab+shstrtab_size);
+
+    ph_buffer_truncate(out, 0);
+    if(ph_buffer_reserve(out, sections+
+                         PH_ELF_SECTION_AMOUNT*PH_ELF_SECTION_SIZE)){
+        return 1;
+    }
+
+    /* Header */
+    if(ph_buffer_write(out, (unsigned char*)ident, sizeof(ident))) return 1;
+    /* Relocatable file */
+    if(ph_elf_put16(out, 1)) return 1;
+    if(ph_elf_put16(out, PH_ELF_MACHINE_RISCV)) return 1;
+    if(ph_obj_put32(out, 1)) return 1;
+    /* No entry point and no program headers */
+    if(ph_obj_put32(out, 0)) return 1;
+    if(ph_obj_put32(out, 0)) return 1;
+    if(ph_obj_put32(out, sections)) return 1;
+    /* Soft float ABI without compressed instructions, like rv32i code */
+    if(ph_obj_put32(out, 0)) return 1;
+    if(ph_elf_put16(out, PH_ELF_HEADER_SIZE)) return 1;
+    if(ph_elf_put16(out, 0)) return 1;
+    if(ph_elf_put16(out, 0)) return 1;
+    if(ph_elf_put16(out, PH_ELF_SECTION_SIZE)) return 1;
+    if(ph_elf_put16(out, PH_ELF_SECTION_AMOUNT)) return 1;
+    if(ph_elf_put16(out, PH_ELF_SHSTRTAB)) return 1;
+
+    /* Data, followed by its size */
+    if(ph_buffer_write(out, (unsigned char*)data, size)) return 1;
+    if(ph_elf_pad(out)) return 1;
+    if(ph_obj_put32(out, size)) return 1;
+
+    /* Symbols, the global ones come after the local ones */
+    if(ph_elf_symbol(out, 0, 0, 0, 0, PH_ELF_NULL)) return 1;
+    if(ph_elf_symbol(out, 0, 0, 0,
+                     PH_ELF_SYMBOL_INFO(PH_ELF_STB_LOCAL,
+                                        PH_ELF_STT_SECTION), PH_ELF_DATA)){
+        return 1;
+    }
+    if(ph_elf_symbol(out, 1, 0, size,
+                     PH_ELF_SYMBOL_INFO(PH_ELF_STB_GLOBAL,
+                                        PH_ELF_STT_OBJECT), PH_ELF_DATA)){
+        return 1;
+    }
+    if(ph_elf_symbol(out, strlen(name)+2, PH_ELF_ALIGN(size), 4,
+                     PH_ELF_SYMBOL_INFO(PH_ELF_STB_GLOBAL,
+                                        PH_ELF_STT_OBJECT), PH_ELF_DATA)){
+        return 1;
+    }
+
+    /* Symbol names */
+    if(ph_buffer_putc(out, 0)) return 1;
+    if(ph_elf_string(out, "", name, "")) return 1;
+    if(ph_elf_string(out, "", name, "_len")) return 1;
+
+    /* Section names */
+    if(ph_buffer_putc(out, 0)) return 1;
+    if(ph_elf_string(out, ".rodata.", name, "")) return 1;
+    if(ph_elf_string(out, ".symtab", "", "")) return 1;
+    if(ph_elf_string(out, ".strtab", "", "")) return 1;
+    if(ph_elf_string(out, ".shstrtab", "", "")) return 1;
+    if(ph_elf_pad(out)) return 1;
+
+    /* Section headers */
+    if(ph_elf_section(out, 0, PH_ELF_SHT_NULL, 0, 0, 0, 0, 0, 0, 0)){
+        return 1;
+    }
+    if(ph_elf_section(out, data_name, PH_ELF_SHT_PROGBITS, PH_ELF_SHF_ALLOC,
+                      PH_ELF_HEADER_SIZE, data_size, 0, 0, 4, 0)){
+        return 1;
+    }
+    if(ph_elf_section(out, symtab_name, PH_ELF_SHT_SYMTAB, 0, symtab,
+                      4*PH_ELF_SYMBOL_SIZE, PH_ELF_STRTAB, 2, 4,
+                      PH_ELF_SYMBOL_SIZE)){
+        return 1;
+    }
+    if(ph_elf_section(out, strtab_name, PH_ELF_SHT_STRTAB, 0, strtab,
+                      strtab_size, 0, 0, 1, 0)){
+        return 1;
+    }
+    if(ph_elf_section(out, shstrtab_name, PH_ELF_SHT_STRTAB, 0, shstrtab,
+                      shstrtab_size, 0, 0, 1, 0)){
+        return 1;
+    }
+
+    return 0;
+}
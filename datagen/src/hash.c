@@ -0,0 +1,73 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <hash.h>
+
+#include <string.h>
+
+unsigned long int ph_hash_string(unsigned long int seed, const char *str,
+                                 size_t len) {
+    /* 32-bit FNV-1a with a seeded offset basis */
+    unsigned long int hash = (2166136261UL^seed)&0xFFFFFFFF;
+    size_t i;
+
+    for(i=0;i<len;i++){
+        hash ^= (unsigned char)str[i];
+        hash = (hash*16777619UL)&0xFFFFFFFF;
+    }
+
+    return hash;
+}
+
+size_t ph_hash_slot(unsigned long int hash, unsigned char bits) {
+    if(!bits) return 0;
+
+    /* Fibonacci hashing to use the high bits of the hash */
+    return ((hash*2654435769UL)&0xFFFFFFFF)>>(32-bits);
+}
+
+size_t ph_hash_find(const PHHash *hash, const char *str, size_t len) {
+    unsigned char n;
+    const char *name;
+
+    n = hash->slots[ph_hash_slot(ph_hash_string(hash->seed, str, len),
+                                 hash->bits)];
+    if(!n) return hash->count;
+
+    name = hash->names[n-1];
+    if(strncmp(name, str, len) || name[len]) return hash->count;
+
+    return n-1;
+}
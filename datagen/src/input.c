@@ -0,0 +1,147 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <input.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+int ph_input_open(PHInput *input, FILE *in) {
+    struct stat st;
+    int fd = fileno(in);
+
+    input->data = NULL;
+    input->size = 0;
+    input->mapped = 0;
+    input->released = 0;
+    input->borrowed = 0;
+
+    /* Regular files are mapped directly, everything else (pipes, terminals,
+     * etc.) is read in large blocks. */
+    if(fd >= 0 && !fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0){
+        void *data;
+
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data != MAP_FAILED){
+            posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+
+            input->data = data;
+            input->size = st.st_size;
+            input->mapped = 1;
+
+            return 0;
+        }
+    }
+
+    return ph_input_read(input, in);
+}
+
+int ph_input_read(PHInput *input, FILE *in) {
+    size_t size;
+
+    input->data = NULL;
+    input->size = 0;
+    input->mapped = 0;
+    input->released = 0;
+    input->borrowed = 0;
+
+    if(ph_buffer_init(&input->buffer, PH_INPUT_BLOCK_SIZE)) return 1;
+
+    do{
+        if(ph_buffer_alloc(&input->buffer, PH_INPUT_BLOCK_SIZE)){
+            ph_buffer_free(&input->buffer);
+            return 1;
+        }
+
+        size = fread(input->buffer.data+input->buffer.cur, 1,
+                     PH_INPUT_BLOCK_SIZE, in);
+
+        input->buffer.cur += size;
+        input->buffer.size += size;
+    }while(size == PH_INPUT_BLOCK_SIZE);
+
+    if(ferror(in)){
+        ph_buffer_free(&input->buffer);
+        return 1;
+    }
+
+    input->data = input->buffer.data;
+    input->size = input->buffer.size;
+
+    return 0;
+}
+
+/* Uses data that is already in memory, it must outlive the input */
+void ph_input_mem(PHInput *input, const unsigned char *data, size_t size) {
+    input->data = data;
+    input->size = size;
+    input->mapped = 0;
+    input->released = 0;
+    input->borrowed = 1;
+}
+
+void ph_input_release(PHInput *input, size_t end) {
+    long int page = sysconf(_SC_PAGESIZE);
+
+    if(!input->mapped || page <= 0) return;
+
+    /* The mapping starts on a page boundary */
+    end -= end%page;
+
+    /* Unmap large enough parts at once */
+    if(end >= input->released+PH_INPUT_BLOCK_SIZE){
+        munmap((void*)(input->data+input->released), end-input->released);
+        input->released = end;
+    }
+}
+
+void ph_input_close(PHInput *input) {
+    if(input->mapped){
+        /* The released pages may already be used by another mapping */
+        if(input->size > input->released){
+            munmap((void*)(input->data+input->released),
+                   input->size-input->released);
+        }
+    }else if(!input->borrowed){
+        ph_buffer_free(&input->buffer);
+    }
+
+    input->data = NULL;
+    input->size = 0;
+}
@@ -0,0 +1,67 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHOSPHOR_INPUT_H
+#define PHOSPHOR_INPUT_H
+
+#include <stdio.h>
+#include <buffer.h>
+
+/* Size of the blocks read from streams that can't be mapped. */
+#define PH_INPUT_BLOCK_SIZE (64*1024)
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+
+    unsigned char mapped;
+    /* Size of the start of a mapped input that is already unmapped */
+    size_t released;
+    /* The data belongs to the caller and isn't freed */
+    unsigned char borrowed;
+
+    PHBuffer buffer;
+} PHInput;
+
+int ph_input_open(PHInput *input, FILE *in);
+int ph_input_read(PHInput *input, FILE *in);
+void ph_input_mem(PHInput *input, const unsigned char *data, size_t size);
+/* Unmaps the pages that are entirely before end, once nothing before end will
+ * be used anymore, at least PH_INPUT_BLOCK_SIZE bytes at a time. Does nothing
+ * if the input was not mapped. */
+void ph_input_release(PHInput *input, size_t end);
+void ph_input_close(PHInput *input);
+
+#endif
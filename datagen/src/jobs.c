@@ -0,0 +1,294 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <jobs.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <conv.h>
+#include <input.h>
+
+/* NOTE: Each worker owns a converter and picks the next file to convert from
+ * the job list. The jobs are handed back in the order of the list with
+ * ph_jobs_wait so that the output doesn't depend on the scheduling. */
+
+static void ph_jobs_run(PHJobs *jobs, PHConv *conv, PHJob *job) {
+    FILE *in;
+    PHInput input;
+    char key[PH_CACHE_KEY_MAX];
+
+    if(strcmp(job->path, "-")){
+        in = fopen(job->path, "rb");
+    }else{
+        in = stdin;
+    }
+
+    job->cached = 0;
+
+    if(in == NULL){
+        conv->error = PH_CONV_E_READ;
+
+        job->opened = 0;
+        job->error = conv->error;
+        job->line = 0;
+        job->message = ph_conv_get_error(conv);
+
+        return;
+    }
+
+    job->opened = 1;
+
+    if(ph_input_open(&input, in)){
+        conv->line = 0;
+        conv->error = PH_CONV_E_READ;
+    }else{
+        if(jobs->cache != NULL){
+            ph_cache_key(input.data, input.size, key);
+
+            if(!ph_cache_load(jobs->cache, key, &job->buffer)){
+                /* Reuse the previously converted file */
+                conv->line = 0;
+                conv->error = PH_CONV_SUCCESS;
+
+                job->cached = 1;
+            }
+        }
+
+        if(!job->cached){
+            ph_conv_convert_mem(conv, input.data, input.size);
+
+            if(jobs->cache != NULL && !conv->error){
+                /* Failing to update the cache isn't fatal */
+                ph_cache_store(jobs->cache, key, job-jobs->jobs,
+                               &conv->buffer);
+            }
+        }
+
+        ph_input_close(&input);
+    }
+
+    job->error = conv->error;
+    job->line = conv->line;
+    job->message = ph_conv_get_error(conv);
+
+    if(in != stdin) fclose(in);
+
+    if(job->cached) return;
+
+    /* Hand the output over to the job */
+    job->buffer = conv->buffer;
+    if(ph_buffer_init(&conv->buffer, 64)){
+        conv->buffer.data = NULL;
+    }
+}
+
+static void ph_jobs_fail(PHJob *job) {
+    PHConv conv;
+
+    conv.error = PH_CONV_E_INTERNAL;
+
+    job->opened = 1;
+    job->error = conv.error;
+    job->line = 0;
+    job->message = ph_conv_get_error(&conv);
+}
+
+static void *ph_jobs_worker(void *_jobs) {
+    PHJobs *jobs = _jobs;
+    PHConv conv;
+    unsigned char ready;
+
+    ready = !ph_conv_init(&conv, jobs->commands, NULL);
+
+    while(1){
+        PHJob *job;
+
+        pthread_mutex_lock(&jobs->lock);
+        if(jobs->next >= jobs->count){
+            pthread_mutex_unlock(&jobs->lock);
+            break;
+        }
+        job = jobs->jobs+jobs->next;
+        jobs->next++;
+        pthread_mutex_unlock(&jobs->lock);
+
+        if(ready && conv.buffer.data != NULL){
+            ph_jobs_run(jobs, &conv, job);
+        }else{
+            ph_jobs_fail(job);
+        }
+
+        pthread_mutex_lock(&jobs->lock);
+        job->done = 1;
+        pthread_cond_broadcast(&jobs->cond);
+        pthread_mutex_unlock(&jobs->lock);
+    }
+
+    if(ready) ph_conv_free(&conv);
+
+    return NULL;
+}
+
+int ph_jobs_init(PHJobs *jobs, PHCommands *commands, PHCache *cache,
+                 char **paths, size_t count, size_t threads) {
+    size_t i;
+
+    jobs->jobs = malloc(count*sizeof(PHJob));
+    if(jobs->jobs == NULL) return 1;
+
+    for(i=0;i<count;i++){
+        jobs->jobs[i].path = paths[i];
+        jobs->jobs[i].buffer.data = NULL;
+        jobs->jobs[i].done = 0;
+    }
+
+    jobs->count = count;
+    jobs->next = 0;
+    jobs->commands = commands;
+    jobs->cache = cache;
+
+    /* Don't start more threads than there are files. Without threads the
+     * files are converted by ph_jobs_wait. */
+    if(threads > count) threads = count;
+    if(threads <= 1) threads = 0;
+
+    jobs->threads = NULL;
+    jobs->thread_count = 0;
+    jobs->conv_ready = 0;
+
+    if(!threads){
+        /* A single converter is reused for all the files, the jobs fail if
+         * it can't be created */
+        jobs->conv_ready = !ph_conv_init(&jobs->conv, commands, NULL);
+        return 0;
+    }
+
+    if(pthread_mutex_init(&jobs->lock, NULL)){
+        free(jobs->jobs);
+        return 1;
+    }
+    if(pthread_cond_init(&jobs->cond, NULL)){
+        pthread_mutex_destroy(&jobs->lock);
+        free(jobs->jobs);
+        return 1;
+    }
+
+    jobs->threads = malloc(threads*sizeof(pthread_t));
+    if(jobs->threads == NULL){
+        pthread_cond_destroy(&jobs->cond);
+        pthread_mutex_destroy(&jobs->lock);
+        free(jobs->jobs);
+        return 1;
+    }
+
+    for(i=0;i<threads;i++){
+        if(pthread_create(jobs->threads+i, NULL, ph_jobs_worker, jobs)){
+            break;
+        }
+        jobs->thread_count++;
+    }
+
+    if(!jobs->thread_count){
+        ph_jobs_free(jobs);
+        return 1;
+    }
+
+    return 0;
+}
+
+PHJob *ph_jobs_wait(PHJobs *jobs, size_t i) {
+    PHJob *job = jobs->jobs+i;
+
+    if(jobs->threads == NULL){
+        /* Convert the file in the calling thread */
+        if(jobs->conv_ready && jobs->conv.buffer.data != NULL){
+            ph_jobs_run(jobs, &jobs->conv, job);
+        }else{
+            ph_jobs_fail(job);
+        }
+        job->done = 1;
+
+        return job;
+    }
+
+    pthread_mutex_lock(&jobs->lock);
+    while(!job->done){
+        pthread_cond_wait(&jobs->cond, &jobs->lock);
+    }
+    pthread_mutex_unlock(&jobs->lock);
+
+    return job;
+}
+
+void ph_jobs_release(PHJobs *jobs, size_t i) {
+    if(jobs->jobs[i].buffer.data != NULL){
+        ph_buffer_free(&jobs->jobs[i].buffer);
+    }
+}
+
+void ph_jobs_free(PHJobs *jobs) {
+    size_t i;
+
+    if(jobs->threads != NULL){
+        /* Let the workers finish without starting new jobs */
+        pthread_mutex_lock(&jobs->lock);
+        jobs->next = jobs->count;
+        pthread_mutex_unlock(&jobs->lock);
+
+        for(i=0;i<jobs->thread_count;i++){
+            pthread_join(jobs->threads[i], NULL);
+        }
+        free(jobs->threads);
+        jobs->threads = NULL;
+
+        pthread_cond_destroy(&jobs->cond);
+        pthread_mutex_destroy(&jobs->lock);
+    }
+
+    if(jobs->conv_ready){
+        ph_conv_free(&jobs->conv);
+        jobs->conv_ready = 0;
+    }
+
+    for(i=0;i<jobs->count;i++){
+        ph_jobs_release(jobs, i);
+    }
+    free(jobs->jobs);
+    jobs->jobs = NULL;
+}
@@ -0,0 +1,86 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHOSPHOR_JOBS_H
+#define PHOSPHOR_JOBS_H
+
+#include <pthread.h>
+
+#include <buffer.h>
+#include <cache.h>
+#include <commandproperties.h>
+#include <conv.h>
+
+typedef struct {
+    char *path;
+
+    PHBuffer buffer;
+
+    unsigned char opened;
+    int error;
+    size_t line;
+    char *message;
+
+    unsigned char cached;
+    unsigned char done;
+} PHJob;
+
+typedef struct {
+    PHJob *jobs;
+    size_t count;
+    size_t next;
+
+    PHCommands *commands;
+    PHCache *cache;
+
+    pthread_t *threads;
+    size_t thread_count;
+
+    /* Converter of the calling thread, that converts the files without
+     * threads */
+    PHConv conv;
+    unsigned char conv_ready;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} PHJobs;
+
+int ph_jobs_init(PHJobs *jobs, PHCommands *commands, PHCache *cache,
+                 char **paths, size_t count, size_t threads);
+PHJob *ph_jobs_wait(PHJobs *jobs, size_t i);
+void ph_jobs_release(PHJobs *jobs, size_t i);
+void ph_jobs_free(PHJobs *jobs);
+
+#endif
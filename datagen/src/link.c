@@ -35,314 +35,1344 @@
 
 #include <link.h>
 
+#include <bytecode.h>
 #include <format.h>
+#include <object.h>
 
 #include <stdlib.h>
 #include <string.h>
 
 int ph_linker_init(PHLinker *linker, PHCommands *commands) {
-    if(ph_buffer_init(&linker->in_buffer, 64)) return 1;
-    if(ph_buffer_init(&linker->out_buffer, 64)){
-        ph_buffer_free(&linker->in_buffer);
+    if(ph_arena_init(&linker->scratch, 4096)) return 1;
+    if(ph_buffer_init(&linker->out_buffer, 64)) return 1;
+    if(ph_symtab_init(&linker->labels)){
+        ph_buffer_free(&linker->out_buffer);
+        return 1;
+    }
+    if(ph_dict_init(&linker->dict)){
+        ph_buffer_free(&linker->out_buffer);
+        ph_symtab_free(&linker->labels);
+        return 1;
+    }
+    if(ph_buffer_init(&linker->packed, 64)){
+        ph_buffer_free(&linker->out_buffer);
+        ph_symtab_free(&linker->labels);
+        ph_dict_free(&linker->dict);
+        return 1;
+    }
+    if(ph_buffer_init(&linker->pool, 64)){
+        ph_buffer_free(&linker->out_buffer);
+        ph_symtab_free(&linker->labels);
+        ph_dict_free(&linker->dict);
+        ph_buffer_free(&linker->packed);
+        return 1;
+    }
+    if(ph_symtab_init(&linker->pool_names)){
+        ph_buffer_free(&linker->out_buffer);
+        ph_symtab_free(&linker->labels);
+        ph_dict_free(&linker->dict);
+        ph_buffer_free(&linker->packed);
+        ph_buffer_free(&linker->pool);
         return 1;
     }
-    if(ph_arena_init(&linker->names, 64)){
-        ph_buffer_free(&linker->in_buffer);
+    if(ph_symtab_init(&linker->pool_texts)){
         ph_buffer_free(&linker->out_buffer);
+        ph_symtab_free(&linker->labels);
+        ph_dict_free(&linker->dict);
+        ph_buffer_free(&linker->packed);
+        ph_buffer_free(&linker->pool);
+        ph_symtab_free(&linker->pool_names);
         return 1;
     }
-    linker->labels = NULL;
+    if(ph_symtab_init(&linker->vars)){
+        ph_buffer_free(&linker->out_buffer);
+        ph_symtab_free(&linker->labels);
+        ph_dict_free(&linker->dict);
+        ph_buffer_free(&linker->packed);
+        ph_buffer_free(&linker->pool);
+        ph_symtab_free(&linker->pool_names);
+        ph_symtab_free(&linker->pool_texts);
+        return 1;
+    }
+
+    linker->inputs = NULL;
+    linker->input_count = 0;
+    linker->input_max = 0;
+
+    linker->objects = NULL;
+    linker->object_count = 0;
+    linker->object_max = 0;
+
+    linker->blocks = NULL;
+    linker->block_count = 0;
+    linker->block_max = 0;
+
+    linker->refs = NULL;
+    linker->ref_count = 0;
+    linker->ref_max = 0;
 
     linker->commands = commands;
 
-    linker->error = 0;
+    linker->gc = 0;
+    linker->gc_bytes = 0;
+    linker->gc_labels = 0;
+
+    linker->compress = 0;
+    linker->text_bytes = 0;
+    linker->packed_bytes = 0;
+
+    linker->layout = 0;
+    linker->lines = 0;
+    linker->verbatim = 0;
 
-    linker->label_count = 0;
+    /* The strings are only needed while linking, they can point into the
+     * inputs */
+    linker->pool_names.copy = 0;
+    linker->pool_texts.copy = 0;
+    linker->pool_count = 0;
+    linker->pooled_bytes = 0;
+    linker->vars.copy = 0;
+
+    linker->error = 0;
 
     linker->infostr = (unsigned char*)"";
     return 0;
 }
 
+/* Makes room for one more element in an array that grows geometrically */
+static int ph_linker_grow(void **array, size_t *max, size_t count,
+                          size_t size) {
+    if(count >= *max){
+        size_t new_max = *max ? *max*2 : 8;
+        void *new;
+
+        new = realloc(*array, new_max*size);
+        if(new == NULL) return 1;
+
+        *array = new;
+        *max = new_max;
+    }
+
+    return 0;
+}
+
 int ph_linker_add_file(PHLinker *linker, FILE *in) {
-    size_t size;
+    if(ph_linker_grow((void**)&linker->inputs, &linker->input_max,
+                      linker->input_count, sizeof(PHInput))){
+        return 1;
+    }
 
-    fseek(in, 0, SEEK_END);
-    size = ftell(in);
-    rewind(in);
+    /* Regular files are mapped, pipes are read in blocks */
+    if(ph_input_open(linker->inputs+linker->input_count, in)) return 1;
 
-    if(ph_buffer_alloc(&linker->in_buffer, size)) return 1;
+    linker->input_count++;
 
-    if(fread(linker->in_buffer.data+linker->in_buffer.cur, 1, size,
-             in) != size) return 1;
+    return 0;
+}
 
-    linker->in_buffer.cur += size;
-    linker->in_buffer.size += size;
+/* Links an object file that is already in memory, it must outlive the
+ * linker */
+int ph_linker_add_mem(PHLinker *linker, const unsigned char *data,
+                      size_t size) {
+    if(ph_linker_grow((void**)&linker->inputs, &linker->input_max,
+                      linker->input_count, sizeof(PHInput))){
+        return 1;
+    }
+
+    ph_input_mem(linker->inputs+linker->input_count, data, size);
+
+    linker->input_count++;
 
     return 0;
 }
 
-int ph_linker_link(PHLinker *linker, char *start) {
+static int ph_linker_read(PHLinker *linker, PHObject *obj, PHInput *input,
+                          size_t pos) {
+    int rc;
+
+    rc = ph_obj_read(obj, input->data+pos, input->size-pos);
+    if(rc == PH_OBJ_E_VERSION){
+        linker->error = PH_LINK_E_OBJECT_VERSION;
+        return 1;
+    }else if(rc){
+        linker->error = PH_LINK_E_INVALID_OBJECT;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int ph_linker_add_block(PHLinker *linker, size_t input, size_t start,
+                               unsigned char fallthrough) {
+    PHBlock *block;
+
+    if(ph_linker_grow((void**)&linker->blocks, &linker->block_max,
+                      linker->block_count, sizeof(PHBlock))){
+        linker->error = PH_LINK_E_INTERNAL;
+        return 1;
+    }
+
+    block = linker->blocks+linker->block_count;
+
+    block->input = input;
+    block->obj = linker->object_count-1;
+    block->start = start;
+    block->fallthrough = fallthrough;
+    block->reachable = !linker->gc;
+    block->pack = 0;
+    block->packed = PH_LINK_NONE;
+
+    linker->block_count++;
+
+    return 0;
+}
+
+static int ph_linker_add_ref(PHLinker *linker, size_t target, size_t offset,
+                             unsigned char pool) {
+    PHRef *ref;
+
+    if(ph_linker_grow((void**)&linker->refs, &linker->ref_max,
+                      linker->ref_count, sizeof(PHRef))){
+        linker->error = PH_LINK_E_INTERNAL;
+        return 1;
+    }
+
+    ref = linker->refs+linker->ref_count++;
+
+    ref->target = target;
+    ref->offset = offset;
+    ref->size = 1;
+    ref->pool = pool;
+
+    return 0;
+}
+
+/* Checks if the payload of a block ends with text, the last relocation comes
+ * after a command */
+static unsigned char ph_linker_text_end(PHObject *obj, PHBlock *block) {
+    PHObjReloc reloc;
+    size_t pos = block->start;
+    size_t n;
+
+    if(block->reloc_end > block->reloc_start){
+        ph_obj_reloc(obj, block->reloc_end-1, &reloc);
+        pos = reloc.offset;
+    }
+
+    while(pos < block->end){
+        n = ph_bytecode_text_size(obj->payload+pos, block->end-pos);
+        if(pos+n == block->end) return n != 0;
+
+        if(!n){
+            n = ph_bytecode_cmd_size(obj->payload+pos, block->end-pos);
+            if(!n) return 0;
+        }
+
+        pos += n;
+    }
+
+    return 0;
+}
+
+/* Cuts the last object read into blocks and adds its labels */
+static int ph_linker_add_object(PHLinker *linker, size_t input) {
+    PHObject *obj = linker->objects+linker->object_count-1;
+    PHObjLabel label;
+    PHObjReloc reloc;
+    size_t first = linker->block_count;
     size_t i;
-    static unsigned char label[PH_CONV_TOKEN_MAX+1];
-    size_t label_cur = 0;
-    static unsigned char str[PH_CONV_TOKEN_MAX+1];
-    unsigned char str_cur = 0;
-    unsigned char in_label = 0;
+    size_t n = 0;
 
-    size_t label_id = 0;
+    /* The engine runs into the start of an object from the end of the
+     * previous one */
+    if(ph_linker_add_block(linker, input, 0, linker->object_count > 1 &&
+                           (obj[-1].flags&PH_OBJ_FALLTHROUGH))){
+        return 1;
+    }
 
-    unsigned char in_cmd = 0;
+    for(i=0;i<obj->label_count;i++){
+        ph_obj_label(obj, i, &label);
 
-    size_t start_bytes = 0;
+        /* Check if the label is duplicated */
 
-    size_t cmd_str = 0;
-    size_t cmd_offset = 0;
+        if(ph_symtab_find(&linker->labels, label.name,
+                          strlen(label.name)) < linker->labels.count){
+            linker->error = PH_LINK_E_DUPLICATE_LABEL;
+            linker->infostr = (unsigned char*)label.name;
+            return 1;
+        }
 
-    size_t byte_count = 0;
+        /* Add the label to the label list */
 
-    /* Search all labels */
-    for(i=0;i<linker->in_buffer.size;i++){
-        unsigned char c = linker->in_buffer.data[i];
-        if(in_label){
-            if(c == 0){
-                PHLabel *new = NULL;
-                size_t n;
-
-                /* Add the label to the label list */
-
-                in_label = 0;
-                label[label_cur] = 0;
-
-                for(n=0;n<linker->label_count;n++){
-                    if(!strcmp(linker->labels[n].name, (char*)label)){
-                        linker->error = PH_LINK_E_DUPLICATE_LABEL;
-                        linker->infostr = label;
-                        return 1;
-                    }
-                }
+        if(ph_symtab_add(&linker->labels, label.name, strlen(label.name),
+                         linker->block_count)){
+            linker->error = PH_LINK_E_INTERNAL;
+            return 1;
+        }
 
-                /* Check if the label is duplicated */
+        if(ph_linker_add_block(linker, input, label.offset,
+                               label.flags&PH_OBJ_FALLTHROUGH)){
+            return 1;
+        }
+    }
 
-                new = realloc(linker->labels, (linker->label_count+1)*
-                              sizeof(PHLabel));
-                if(new == NULL){
-                    linker->error = PH_LINK_E_INTERNAL;
-                    return 1;
-                }
-                linker->labels = new;
+    /* The relocations at the offset of a label belong to the block before the
+     * label */
+    for(i=first;i<linker->block_count;i++){
+        PHBlock *block = linker->blocks+i;
+
+        block->end = i+1 < linker->block_count ? block[1].start :
+                     obj->payload_size;
+
+        block->reloc_start = n;
+        block->refs = linker->ref_count;
+        for(;n<obj->reloc_count;n++){
+            ph_obj_reloc(obj, n, &reloc);
+            if(reloc.offset > block->end) break;
+
+            if(ph_linker_add_ref(linker, 0, reloc.offset-block->start, 0)){
+                return 1;
+            }
+        }
+        block->reloc_end = n;
+        block->ref_count = n-block->reloc_start;
+
+        /* The text of an empty block is the one of the block before it */
+        if(block->start == block->end && block->reloc_start == n){
+            block->text_end = block->fallthrough && i &&
+                              block[-1].text_end;
+        }else{
+            block->text_end = ph_linker_text_end(obj, block);
+        }
+    }
+
+    return 0;
+}
 
-                linker->labels[linker->label_count]
-                              .name = ph_arena_alloc(&linker->names,
-                                                     1, label_cur+1);
+/* Finds the block each relocation points to. Undefined labels are errors
+ * even in the blocks that are removed. */
+static int ph_linker_resolve(PHLinker *linker) {
+    PHObjReloc reloc;
+    size_t i, n;
 
-                if(linker->labels[linker->label_count].name == NULL){
-                    linker->error = PH_LINK_E_INTERNAL;
+    for(i=0;i<linker->block_count;i++){
+        PHBlock *block = linker->blocks+i;
+        PHRef *ref = linker->refs+block->refs;
+
+        for(n=block->reloc_start;n<block->reloc_end;n++,ref++){
+            size_t symbol;
+
+            ph_obj_reloc(linker->objects+block->obj, n, &reloc);
+
+            symbol = ph_symtab_find(&linker->labels, reloc.name,
+                                    strlen(reloc.name));
+            if(symbol >= linker->labels.count){
+                linker->error = PH_LINK_E_UNKNOWN_LABEL;
+                linker->infostr = (unsigned char*)reloc.name;
+                return 1;
+            }
+
+            ref->target = linker->labels.symbols[symbol].pos;
+        }
+    }
+
+    return 0;
+}
+
+/* Marks the blocks reachable from the block root through the label
+ * references and by running from a block into the next one. */
+static int ph_linker_mark(PHLinker *linker, size_t root) {
+    PHArenaMark mark;
+    size_t *stack;
+    size_t top = 0;
+
+    ph_arena_mark(&linker->scratch, &mark);
+
+    /* Each block is pushed at most once */
+    stack = ph_arena_alloc(&linker->scratch, sizeof(size_t),
+                           linker->block_count);
+    if(stack == NULL){
+        linker->error = PH_LINK_E_INTERNAL;
+        return 1;
+    }
+
+    linker->blocks[root].reachable = 1;
+    stack[top++] = root;
+
+    while(top){
+        size_t i = stack[--top];
+        PHBlock *block = linker->blocks+i;
+        size_t n;
+
+        for(n=0;n<block->ref_count;n++){
+            size_t target = linker->refs[block->refs+n].target;
+
+            if(!linker->blocks[target].reachable){
+                linker->blocks[target].reachable = 1;
+                stack[top++] = target;
+            }
+        }
+
+        if(i+1 < linker->block_count && block[1].fallthrough &&
+           !block[1].reachable){
+            block[1].reachable = 1;
+            stack[top++] = i+1;
+        }
+    }
+
+    ph_arena_rollback(&linker->scratch, &mark);
+
+    return 0;
+}
+
+/* Size of the parts of the input that are copied before being released */
+#define PH_LINK_CHUNK (1024*1024)
+
+/* Copies a part of an input to the output and releases it */
+static void ph_linker_write(PHLinker *linker, PHInput *input, size_t start,
+                            size_t end) {
+    while(start < end){
+        size_t size = end-start < PH_LINK_CHUNK ? end-start : PH_LINK_CHUNK;
+
+        ph_buffer_write(&linker->out_buffer,
+                        (unsigned char*)input->data+start, size);
+        ph_input_release(input, start+size);
+
+        start += size;
+    }
+}
+
+/* What ph_linker_pack does with the strings of a block */
+enum {
+    /* Count the uses of the strings and give the variables a slot */
+    PH_PACK_COUNT,
+    /* Check if the block has to be packed */
+    PH_PACK_FIND,
+    /* Add the text to the sample the dictionary is built from */
+    PH_PACK_SAMPLE,
+    /* Write the block to the packed buffer */
+    PH_PACK_WRITE
+};
+
+/* Shortest text run that is pooled */
+#define PH_LINK_POOL_TEXT_MIN 8
+
+/* Position of the pooled text runs until they are written to the pool */
+#define PH_LINK_UNWRITTEN ((size_t)-2)
+
+static int ph_linker_count(PHSymtab *table, const unsigned char *str,
+                           size_t len) {
+    size_t i = ph_symtab_find(table, (const char*)str, len);
+
+    if(i < table->count){
+        table->symbols[i].pos++;
+        return 0;
+    }
+
+    return ph_symtab_add(table, (const char*)str, len, 1);
+}
+
+/* Returns the symbol of a pooled string, or NULL if it isn't pooled */
+static PHSymbol *ph_linker_pooled(PHSymtab *table, const unsigned char *str,
+                                  size_t len) {
+    size_t i = ph_symtab_find(table, (const char*)str, len);
+
+    if(i >= table->count || table->symbols[i].pos == PH_LINK_NONE){
+        return NULL;
+    }
+
+    return table->symbols+i;
+}
+
+/* Writes text to out, compressed if needed */
+static int ph_linker_put_text(PHLinker *linker, PHBuffer *out,
+                              const unsigned char *text, size_t size) {
+    size_t start = out->size;
+
+    if(!linker->compress){
+        return ph_buffer_write(out, (unsigned char*)text, size);
+    }
+
+    if(ph_dict_compress(&linker->dict, text, size, out)) return 1;
+
+    linker->text_bytes += size;
+    linker->packed_bytes += out->size-start;
+
+    return 0;
+}
+
+/* Writes a reference to a string of the pool to a block being packed */
+static int ph_linker_put_pooled(PHLinker *linker, PHBlock *block,
+                                size_t pos) {
+    if(ph_buffer_putc(&linker->packed, PH_CMD_TEXTREF)) return 1;
+
+    return ph_linker_add_ref(linker, pos, linker->packed.size-block->packed,
+                             1);
+}
+
+static int ph_linker_pack_text(PHLinker *linker, PHBlock *block,
+                               const unsigned char *text, size_t size,
+                               int mode) {
+    PHSymbol *symbol = NULL;
+
+    if(size >= PH_LINK_POOL_TEXT_MIN){
+        if(mode == PH_PACK_COUNT){
+            return ph_linker_count(&linker->pool_texts, text, size);
+        }
+        symbol = ph_linker_pooled(&linker->pool_texts, text, size);
+    }
+
+    switch(mode){
+        case PH_PACK_FIND:
+            if(symbol != NULL) block->pack = 1;
+            return 0;
+
+        case PH_PACK_SAMPLE:
+            return ph_dict_sample(&linker->dict, text, size);
+
+        case PH_PACK_WRITE:
+            if(symbol == NULL){
+                return ph_linker_put_text(linker, &linker->packed, text,
+                                          size);
+            }
+
+            /* The text is written to the pool the first time it is used, as
+             * the dictionary is needed to compress it */
+            if(symbol->pos == PH_LINK_UNWRITTEN){
+                symbol->pos = linker->pool.size;
+                if(ph_linker_put_text(linker, &linker->pool, text, size) ||
+                   ph_buffer_putc(&linker->pool, 0)){
                     return 1;
                 }
+            }
 
-                memcpy(linker->labels[linker->label_count].name, label,
-                       label_cur+1);
-                linker->labels[linker->label_count].pos = i;
+            return ph_linker_put_pooled(linker, block, symbol->pos);
+    }
 
-                linker->label_count++;
-            }else{
-                if(label_cur < PH_CONV_TOKEN_MAX-1){
-                    label[label_cur] = c;
-                    label_cur++;
-                }
+    return 0;
+}
+
+/* Returns the size of the first line of a text run, wrapped like the engine
+ * does it at run time, or 0 if it doesn't have a line it can print */
+static size_t ph_linker_line(PHLinker *linker, const unsigned char *text,
+                             size_t size) {
+    size_t w = linker->layout;
+    size_t pos = 0;
+    size_t saved;
+    size_t i, n;
+
+    /* The end of the run is a command, which ends the line */
+#define _PEEK() (pos < size ? text[pos] : -1)
+
+    for(i=0;i<w && _PEEK() >= 0x20;){
+        /* Move to the next boundary if the text up to it fits */
+        saved = pos;
+        for(n=i;;n++,pos++){
+            if(n >= w){
+                pos = saved;
+                break;
+            }
+            if(_PEEK() == ' ' || _PEEK() == '\t' || _PEEK() == '\n' ||
+               _PEEK() < 0){
+                break;
             }
-        }else if(c == PH_CMD_LABEL){
-            in_label = 1;
-            label_cur = 0;
         }
+        if(_PEEK() < 0) break;
+        if(n < w){
+            /* The boundary is part of the line */
+            pos++;
+            if(text[pos-1] == '\n') break;
+            n++;
+        }
+        i = n;
     }
 
-    label_id = 0;
+#undef _PEEK
 
-    /* Update the label addresses */
-    for(i=0;i<linker->in_buffer.size;i++){
-        unsigned char c = linker->in_buffer.data[i];
+    return pos;
+}
 
-        if(in_label){
-            if(c == 0){
-                /* Update the label pos */
+/* Packs a text run. If lay_out is set, it is cut in lines that each start
+ * with a line record, up to the first one the engine can't print. */
+static int ph_linker_pack_run(PHLinker *linker, PHBlock *block,
+                              const unsigned char *text, size_t size,
+                              unsigned char lay_out, int mode) {
+    size_t n;
+
+    while(lay_out && size){
+        n = ph_linker_line(linker, text, size);
+        if(!n) break;
+
+        if(mode == PH_PACK_WRITE){
+            if(ph_buffer_putc(&linker->packed, PH_CMD_LINE) ||
+               ph_buffer_putc(&linker->packed, n)){
+                return 1;
+            }
+            linker->lines++;
+        }
+        if(ph_linker_pack_text(linker, block, text, n, mode)) return 1;
 
-                linker->labels[label_id].pos -= (i-byte_count);
+        text += n;
+        size -= n;
+    }
 
-                label_id++;
+    if(!size) return 0;
 
-                in_label = 0;
+    return ph_linker_pack_text(linker, block, text, size, mode);
+}
+
+/* Replaces the name of the variable of a var command by its slot. The
+ * variables get their slot in the order they are counted in. */
+static int ph_linker_pack_var(PHLinker *linker, PHBlock *block,
+                              const unsigned char *code, size_t size,
+                              int mode) {
+    /* The name comes after the subcommand and the value of set, and ends
+     * with a NUL */
+    size_t start = code[1] == PH_CMD_VAR_SET ? 6 : 2;
+    size_t i = ph_symtab_find(&linker->vars, (const char*)code+start,
+                              size-start-1);
+
+    switch(mode){
+        case PH_PACK_COUNT:
+            if(i < linker->vars.count) return 0;
+            return ph_symtab_add(&linker->vars, (const char*)code+start,
+                                 size-start-1, i);
+
+        case PH_PACK_FIND:
+            block->pack = 1;
+            return 0;
+
+        case PH_PACK_WRITE:
+            if(i >= linker->vars.count) return 1;
+            return ph_buffer_write(&linker->packed, (unsigned char*)code,
+                                   start) ||
+                   ph_buffer_putc(&linker->packed, i);
+    }
+
+    return 0;
+}
+
+static int ph_linker_pack_part(PHLinker *linker, PHBlock *block,
+                               const unsigned char *code, size_t size,
+                               int mode) {
+    const unsigned char *payload = linker->objects[block->obj].payload;
+    size_t pos = 0;
+
+    while(pos < size){
+        size_t n = ph_bytecode_text_size(code+pos, size-pos);
+
+        if(n){
+            /* The text that goes on in the previous or in the next block is
+             * laid out at run time, as the engine doesn't always run into
+             * it */
+            unsigned char lay_out = linker->layout && !linker->verbatim &&
+                !(code+pos == payload+block->start && block->fallthrough &&
+                  block != linker->blocks && block[-1].reachable &&
+                  block[-1].text_end) &&
+                !(code+pos+n == payload+block->end && block->text_end &&
+                  block+1 < linker->blocks+linker->block_count &&
+                  block[1].fallthrough);
+
+            if(ph_linker_pack_run(linker, block, code+pos, n, lay_out,
+                                  mode)){
+                return 1;
             }
-        }else if(c == PH_CMD_LABEL){
-            in_label = 1;
-            label_cur = 0;
-        }else{
-            if(!in_cmd){
-                size_t n;
 
-                for(n=0;n<linker->commands->labelcmd_count;n++){
-                    if(c == linker->commands->labelcmds[n].id){
-                        in_cmd = 1;
-                        cmd_str = linker->commands->labelcmds[n].str_id;
-                        cmd_offset = linker->commands->labelcmds[n].offset;
+            pos += n;
+            continue;
+        }
 
-                        str_cur = 0;
+        /* Anything that isn't a command is copied as is up to the end of the
+         * part, as its size is unknown */
+        n = ph_bytecode_cmd_size(code+pos, size-pos);
+        if(n && code[pos] == PH_CMD_STARTVERBATIM) linker->verbatim = 1;
+        if(n && code[pos] == PH_CMD_ENDVERBATIM) linker->verbatim = 0;
+        if(n && code[pos] == PH_CMD_VAR){
+            if(ph_linker_pack_var(linker, block, code+pos, n, mode)) return 1;
 
-                        break;
-                    }
-                }
+            pos += n;
+            continue;
+        }
+        if(!n) n = size-pos;
 
-                /* Output the char */
+        if(mode == PH_PACK_WRITE &&
+           ph_buffer_write(&linker->packed, (unsigned char*)code+pos, n)){
+            return 1;
+        }
 
-                byte_count++;
-            }else{
-                if(!cmd_str && !cmd_offset){
-                    if(c == 0){
-                        size_t n;
+        pos += n;
+    }
 
-                        str[str_cur] = 0;
+    return 0;
+}
+
+/* Returns the offset of the case or of the dcase that ends a part, or the
+ * size of the part if it doesn't end with one. The label of a case comes
+ * right after its name, so it always ends the part before its relocation. */
+static size_t ph_linker_case_start(const unsigned char *code, size_t size) {
+    size_t pos = 0;
+    size_t n;
+
+    while(pos < size){
+        n = ph_bytecode_text_size(code+pos, size-pos);
+        if(!n){
+            n = ph_bytecode_cmd_size(code+pos, size-pos);
+            if(!n) return size;
+
+            if((code[pos] == PH_CMD_CASE || code[pos] == PH_CMD_DCASE) &&
+               pos+n == size){
+                return pos;
+            }
+        }
+
+        pos += n;
+    }
 
-                        /* Finished loading the label. */
+    return size;
+}
+
+/* Returns the number of cases that follow each other from the one at pos,
+ * which ends before the relocation first */
+static size_t ph_linker_case_run(PHLinker *linker, PHBlock *block,
+                                 size_t first, size_t pos) {
+    PHObject *obj = linker->objects+block->obj;
+    PHObjReloc reloc;
+    const unsigned char *code;
+    size_t i;
 
-                        for(n=0;n<linker->label_count;n++){
-                            if(!strcmp((char*)str,
-                                       (char*)linker->labels[n].name)){
-                                break;
-                            }
-                        }
-                        if(n == linker->label_count){
-                            linker->error = PH_LINK_E_UNKNOWN_LABEL;
-                            return 1;
-                        }
+    for(i=first;i<block->reloc_end;i++){
+        ph_obj_reloc(obj, i, &reloc);
+        code = obj->payload+pos;
 
-                        byte_count += 4;
+        if(pos >= reloc.offset ||
+           (*code != PH_CMD_CASE && *code != PH_CMD_DCASE) ||
+           ph_bytecode_cmd_size(code, reloc.offset-pos) != reloc.offset-pos){
+            break;
+        }
 
-                        in_cmd = 0;
-                    }else if(str_cur < PH_CONV_TOKEN_MAX-1){
-                        str[str_cur] = c;
-                        str_cur++;
-                    }
-                }else{
-                    /* Output the char */
+        pos = reloc.offset;
+    }
 
-                    byte_count++;
-                }
-                if(cmd_offset) cmd_offset--;
-                else if(cmd_str && c == 0) cmd_str--;
+    return i-first;
+}
+
+/* Adds a reference of a case table, its size is fixed so that all the cases
+ * of the table have the same size */
+static int ph_linker_add_case_ref(PHLinker *linker, PHBlock *block,
+                                  size_t target, unsigned char pool) {
+    if(ph_linker_add_ref(linker, target, linker->packed.size-block->packed,
+                         pool)){
+        return 1;
+    }
+    linker->refs[linker->ref_count-1].size = PH_CASES_ENTRY_SIZE/2;
+
+    return 0;
+}
+
+/* Writes a case table to the packed buffer. codes points to the commands of
+ * the cases, slots to a table of 1<<bits free slots and refs is the index of
+ * the references to their labels. */
+static int ph_linker_write_cases(PHLinker *linker, PHBlock *block,
+                                 const unsigned char **codes, size_t *lens,
+                                 size_t count, size_t *slots,
+                                 unsigned char bits, size_t refs) {
+    PHSymbol *symbol;
+    size_t mask = ((size_t)1<<bits)-1;
+    size_t hash;
+    unsigned char shown;
+    size_t i, n;
+
+    /* Put each name in a slot, the cases with the same name as a previous
+     * one can't be chosen */
+    for(i=0;i<count;i++){
+        hash = PH_CASE_HASH_INIT;
+        for(n=0;n<lens[i];n++) hash = PH_CASE_HASH(hash, codes[i][n+1]);
+
+        for(hash&=mask;slots[hash];hash=(hash+1)&mask){
+            n = slots[hash]-1;
+            if(lens[n] == lens[i] &&
+               !memcmp(codes[n]+1, codes[i]+1, lens[i])){
+                break;
             }
         }
+        if(!slots[hash]) slots[hash] = i+1;
     }
 
-    /* Start the output file with a goto to the start label if needed */
+    if(ph_buffer_putc(&linker->packed, PH_CMD_CASES) ||
+       ph_buffer_putc(&linker->packed, count&0xFF) ||
+       ph_buffer_putc(&linker->packed, count>>8) ||
+       ph_buffer_putc(&linker->packed, bits)){
+        return 1;
+    }
 
-    {
-        size_t n;
-        for(n=0;n<linker->label_count;n++){
-            if(!strcmp(start, linker->labels[n].name)){
-                size_t label_pos;
+    for(i=0;i<=mask;i++){
+        if(ph_buffer_putc(&linker->packed, slots[i]&0xFF) ||
+           ph_buffer_putc(&linker->packed, slots[i]>>8)){
+            return 1;
+        }
+    }
 
-                /* Found the label */
+    /* Bitmap of the dcases */
+    for(i=0;i<count;i+=8){
+        shown = 0;
+        for(n=0;n<8 && i+n<count;n++){
+            if(*codes[i+n] == PH_CMD_DCASE) shown |= 1<<n;
+        }
+        if(ph_buffer_putc(&linker->packed, shown)) return 1;
+    }
 
-                label_pos = linker->labels[n].pos;
+    for(i=0;i<count;i++){
+        symbol = ph_linker_pooled(&linker->pool_names, codes[i]+1, lens[i]);
+        if(symbol == NULL ||
+           ph_linker_add_case_ref(linker, block, symbol->pos, 1) ||
+           ph_linker_add_case_ref(linker, block,
+                                  linker->refs[refs+i].target, 0)){
+            return 1;
+        }
+    }
 
-                if(label_pos){
-                    ph_buffer_putc(&linker->out_buffer, PH_CMD_GOTO);
+    return 0;
+}
 
-                    ph_buffer_putc(&linker->out_buffer,
-                                   label_pos&0xFF);
-                    ph_buffer_putc(&linker->out_buffer,
-                                   (label_pos>>8)&0xFF);
-                    ph_buffer_putc(&linker->out_buffer,
-                                   (label_pos>>16)&0xFF);
-                    ph_buffer_putc(&linker->out_buffer,
-                                   (label_pos>>24)&0xFF);
+/* Packs count cases that follow each other from the one at pos into a case
+ * table. Their names are always pooled, refs is the index of the references
+ * of the block before it is packed. */
+static int ph_linker_pack_cases(PHLinker *linker, PHBlock *block,
+                                size_t first, size_t count, size_t pos,
+                                size_t refs, int mode) {
+    PHObject *obj = linker->objects+block->obj;
+    PHObjReloc reloc;
+    PHArenaMark mark;
+    const unsigned char **codes;
+    size_t *lens;
+    size_t *slots;
+    unsigned char bits = 0;
+    size_t i;
+    int rc = 0;
 
-                    start_bytes = 5;
-                }
+    if(mode == PH_PACK_FIND){
+        block->pack = 1;
+        return 0;
+    }
+    if(mode != PH_PACK_COUNT && mode != PH_PACK_WRITE) return 0;
+
+    while(((size_t)1<<bits) < count*2) bits++;
+    if(bits > PH_CASES_BITS_MAX){
+        linker->error = PH_LINK_E_TOO_MANY_CASES;
+        return 1;
+    }
+
+    ph_arena_mark(&linker->scratch, &mark);
+
+    codes = ph_arena_alloc(&linker->scratch, sizeof(*codes), count);
+    lens = ph_arena_alloc(&linker->scratch, sizeof(size_t), count);
+    slots = ph_arena_alloc(&linker->scratch, sizeof(size_t),
+                           (size_t)1<<bits);
+    if(codes == NULL || lens == NULL || slots == NULL){
+        ph_arena_rollback(&linker->scratch, &mark);
+        linker->error = PH_LINK_E_INTERNAL;
+        return 1;
+    }
+
+    for(i=0;i<count && !rc;i++){
+        ph_obj_reloc(obj, first+i, &reloc);
+
+        /* The name comes after the opcode and ends with a NUL */
+        codes[i] = obj->payload+pos;
+        lens[i] = reloc.offset-pos-2;
+        pos = reloc.offset;
+
+        if(mode == PH_PACK_COUNT){
+            rc = ph_linker_count(&linker->pool_names, codes[i]+1, lens[i]);
+        }
+    }
+
+    if(mode == PH_PACK_WRITE){
+        for(i=0;i<(size_t)1<<bits;i++) slots[i] = 0;
+
+        rc = ph_linker_write_cases(linker, block, codes, lens, count, slots,
+                                   bits, refs+first-block->reloc_start);
+    }
+
+    ph_arena_rollback(&linker->scratch, &mark);
+
+    if(rc) linker->error = PH_LINK_E_INTERNAL;
+
+    return rc;
+}
+
+/* Walks the text runs, the case names and the variables of a block. When
+ * writing it, the block is copied to the packed buffer with its text
+ * compressed, its pooled strings replaced by references, its cases by case
+ * tables and its variable names by their slot, and its references are moved
+ * to the end of the reference list, with the ones to the pool. */
+static int ph_linker_pack(PHLinker *linker, PHBlock *block, int mode) {
+    PHObject *obj = linker->objects+block->obj;
+    PHObjReloc reloc;
+    size_t last = block->start;
+    size_t refs = block->refs;
+    size_t i, n;
+
+    if(mode == PH_PACK_WRITE){
+        block->packed = linker->packed.size;
+        block->refs = linker->ref_count;
+    }
+
+    /* The blocks are packed in order, a block the engine runs into from the
+     * previous one is in the same verbatim state as its end. The other ones
+     * are assumed to be outside of verbatim text. */
+    if(!block->fallthrough || block == linker->blocks || !block[-1].reachable){
+        linker->verbatim = 0;
+    }
+
+    for(i=block->reloc_start;i<block->reloc_end;i++){
+        ph_obj_reloc(obj, i, &reloc);
+
+        /* The cases that follow each other are packed together */
+        n = ph_linker_case_start(obj->payload+last, reloc.offset-last);
+        if(ph_linker_pack_part(linker, block, obj->payload+last, n, mode)){
+            linker->error = PH_LINK_E_INTERNAL;
+            return 1;
+        }
+        last += n;
+
+        if(last < reloc.offset){
+            n = ph_linker_case_run(linker, block, i, last);
+            if(ph_linker_pack_cases(linker, block, i, n, last, refs, mode)){
+                return 1;
             }
+
+            i += n-1;
+            ph_obj_reloc(obj, i, &reloc);
+            last = reloc.offset;
+            continue;
+        }
+
+        if(mode == PH_PACK_WRITE &&
+           ph_linker_add_ref(linker,
+                             linker->refs[refs+i-block->reloc_start].target,
+                             linker->packed.size-block->packed, 0)){
+            return 1;
         }
     }
 
-    in_cmd = 0;
+    if(ph_linker_pack_part(linker, block, obj->payload+last, block->end-last,
+                           mode)){
+        linker->error = PH_LINK_E_INTERNAL;
+        return 1;
+    }
+
+    if(mode == PH_PACK_WRITE){
+        block->size = linker->packed.size-block->packed;
+        block->ref_count = linker->ref_count-block->refs;
+    }
+
+    return 0;
+}
+
+/* Puts the case names in the pool, and the text runs used more than once if
+ * it makes the output smaller. A reference takes an opcode and an offset of
+ * ref_size bytes. The text is compared once compressed, as the dictionary may
+ * already make its copies smaller than a reference. */
+static int ph_linker_pool(PHLinker *linker, size_t ref_size) {
+    size_t i;
+
+    /* The case tables always refer to the names in the pool */
+    for(i=0;i<linker->pool_names.count;i++){
+        PHSymbol *symbol = linker->pool_names.symbols+i;
+        size_t uses = symbol->pos;
+        size_t size = symbol->len+1;
+
+        /* The names are followed by their NUL in the payload */
+        symbol->pos = linker->pool.size;
+        if(ph_buffer_write(&linker->pool, (unsigned char*)symbol->name,
+                           size)){
+            return 1;
+        }
+
+        linker->pool_count++;
+        linker->pooled_bytes += uses*size;
+    }
 
-    /* Replace labels with offsets */
-    for(i=0;i<linker->in_buffer.size;i++){
-        unsigned char c = linker->in_buffer.data[i];
+    for(i=0;i<linker->pool_texts.count;i++){
+        PHSymbol *symbol = linker->pool_texts.symbols+i;
+        size_t uses = symbol->pos;
+        size_t size = symbol->len;
 
-        if(in_label){
-            if(c == 0){
-                in_label = 0;
+        if(linker->compress){
+            ph_buffer_truncate(&linker->packed, 0);
+            if(ph_dict_compress(&linker->dict, (unsigned char*)symbol->name,
+                                symbol->len, &linker->packed)){
+                return 1;
             }
-        }else if(c == PH_CMD_LABEL){
-            in_label = 1;
-        }else{
-            if(!in_cmd){
-                size_t n;
+            size = linker->packed.size;
+        }
 
-                for(n=0;n<linker->commands->labelcmd_count;n++){
-                    if(c == linker->commands->labelcmds[n].id){
-                        in_cmd = 1;
-                        cmd_str = linker->commands->labelcmds[n].str_id;
-                        cmd_offset = linker->commands->labelcmds[n].offset;
+        symbol->pos = PH_LINK_NONE;
+        if(size+1+uses*(1+ref_size) >= uses*size) continue;
 
-                        str_cur = 0;
+        symbol->pos = PH_LINK_UNWRITTEN;
 
-                        break;
-                    }
-                }
+        linker->pool_count++;
+        linker->pooled_bytes += uses*symbol->len;
+    }
+
+    ph_buffer_truncate(&linker->packed, 0);
 
-                /* Output the char */
-
-                ph_buffer_putc(&linker->out_buffer, c);
-            }else{
-                if(!cmd_str && !cmd_offset){
-                    if(c == 0){
-                        size_t n;
-
-                        str[str_cur] = 0;
-
-                        /* Finished loading the label. */
-
-                        for(n=0;n<linker->label_count;n++){
-                            if(!strcmp((char*)str,
-                                       (char*)linker->labels[n].name)){
-                                unsigned long int offset;
-                                size_t label_pos;
-
-                                /* Found the label */
-
-                                label_pos = linker->labels[n].pos;
-
-                                offset = (label_pos+start_bytes-
-                                          linker->out_buffer.cur-5)&
-                                          0xFFFFFFFF;
-
-                                ph_buffer_putc(&linker->out_buffer,
-                                               offset&0xFF);
-                                ph_buffer_putc(&linker->out_buffer,
-                                               (offset>>8)&0xFF);
-                                ph_buffer_putc(&linker->out_buffer,
-                                               (offset>>16)&0xFF);
-                                ph_buffer_putc(&linker->out_buffer,
-                                               (offset>>24)&0xFF);
-                                break;
-                            }
-                        }
-
-                        in_cmd = 0;
-                    }else if(str_cur < PH_CONV_TOKEN_MAX-1){
-                        str[str_cur] = c;
-                        str_cur++;
-                    }
-                }else{
-                    /* Output the char */
-
-                    ph_buffer_putc(&linker->out_buffer, c);
+    return 0;
+}
+
+/* Copies a part of the payload of a block, from the packed buffer if it is
+ * compressed */
+static void ph_linker_write_block(PHLinker *linker, PHBlock *block,
+                                  PHInput *input, size_t start, size_t end) {
+    size_t payload;
+
+    if(block->packed != PH_LINK_NONE){
+        ph_buffer_write(&linker->out_buffer,
+                        linker->packed.data+block->packed+start, end-start);
+        return;
+    }
+
+    payload = linker->objects[block->obj].payload-input->data+block->start;
+    ph_linker_write(linker, input, payload+start, payload+end);
+}
+
+/* Size of the smallest encoding of an offset */
+static unsigned char ph_linker_offset_size(long int offset) {
+    if(offset >= -0x20 && offset < 0x20) return 1;
+    if(offset >= -0x2000 && offset < 0x2000) return 2;
+
+    return 4;
+}
+
+/* Writes an offset to a label in size bytes */
+static void ph_linker_put_offset(PHLinker *linker, long int offset,
+                                 unsigned char size) {
+    unsigned long int n = (unsigned long int)offset<<2;
+    unsigned char i;
+
+    n |= size == 1 ? PH_OFFSET_8 : size == 2 ? PH_OFFSET_16 : PH_OFFSET_32;
+
+    for(i=0;i<size;i++){
+        ph_buffer_putc(&linker->out_buffer, (n>>(i*8))&0xFF);
+    }
+}
+
+/* Position of the target of a reference, relative to the first block. The
+ * pool is right before the blocks. */
+static long int ph_linker_ref_pos(PHLinker *linker, PHRef *ref) {
+    if(ref->pool){
+        return (long int)ref->target-(long int)linker->pool.size;
+    }
+
+    return (long int)linker->blocks[ref->target].pos;
+}
+
+/* Lays the reachable blocks out. The references start with the smallest size
+ * and are made larger until all the offsets fit, the blocks only move forward
+ * so this ends once no reference grows. Returns the size of the blocks. */
+static size_t ph_linker_layout(PHLinker *linker) {
+    unsigned char changed;
+    size_t size;
+    size_t i, n;
+
+    do{
+        size = 0;
+        for(i=0;i<linker->block_count;i++){
+            PHBlock *block = linker->blocks+i;
+
+            block->pos = size;
+            if(!block->reachable) continue;
+
+            size += block->size;
+            for(n=0;n<block->ref_count;n++){
+                size += linker->refs[block->refs+n].size;
+            }
+        }
+
+        changed = 0;
+        for(i=0;i<linker->block_count;i++){
+            PHBlock *block = linker->blocks+i;
+            size_t end = block->pos;
+
+            if(!block->reachable) continue;
+
+            for(n=0;n<block->ref_count;n++){
+                PHRef *ref = linker->refs+block->refs+n;
+                unsigned char needed;
+
+                /* The offset is relative to the end of the reference */
+                end += ref->size;
+                needed = ph_linker_offset_size(
+                    ph_linker_ref_pos(linker, ref)-
+                    (long int)(end+ref->offset));
+                if(needed > ref->size){
+                    ref->size = needed;
+                    changed = 1;
                 }
-                if(cmd_offset) cmd_offset--;
-                else if(cmd_str && c == 0) cmd_str--;
             }
         }
+    }while(changed);
+
+    return size;
+}
+
+/* Copies a block to the output and inserts the offsets to the labels. The
+ * copied parts of mapped inputs are released. */
+static int ph_linker_copy(PHLinker *linker, PHBlock *block, PHInput *input,
+                          size_t start_bytes) {
+    size_t last = 0;
+    size_t n;
+
+    for(n=0;n<block->ref_count;n++){
+        PHRef *ref = linker->refs+block->refs+n;
+        long int offset;
+
+        ph_linker_write_block(linker, block, input, last, ref->offset);
+        last = ref->offset;
+
+        offset = ph_linker_ref_pos(linker, ref)+(long int)start_bytes-
+                 (long int)(linker->out_buffer.cur+ref->size);
+        if(offset < -0x20000000L || offset >= 0x20000000L ||
+           ph_linker_offset_size(offset) > ref->size){
+            linker->error = PH_LINK_E_TOO_FAR;
+            return 1;
+        }
+
+        ph_linker_put_offset(linker, offset, ref->size);
+    }
+
+    ph_linker_write_block(linker, block, input, last, block->size);
+
+    return 0;
+}
+
+/* Links the inputs again without removing the unreachable labels, to know how
+ * much smaller the output gets without them. Their size depends on the pool,
+ * the dictionary and the size of the references, so it's only known once the
+ * output is laid out. Sets size to PH_LINK_NONE if the labels can't all be
+ * linked. */
+static int ph_linker_full_size(PHLinker *linker, char *start, size_t *size) {
+    PHLinker full;
+    size_t i;
+
+    *size = PH_LINK_NONE;
+
+    if(ph_linker_init(&full, linker->commands)){
+        linker->error = PH_LINK_E_INTERNAL;
+        return 1;
+    }
+
+    full.compress = linker->compress;
+    full.layout = linker->layout;
+
+    /* The inputs are not released yet, and the copies don't release them */
+    for(i=0;i<linker->input_count;i++){
+        if(ph_linker_add_mem(&full, linker->inputs[i].data,
+                             linker->inputs[i].size)){
+            ph_linker_free(&full);
+            linker->error = PH_LINK_E_INTERNAL;
+            return 1;
+        }
+    }
+
+    if(!ph_linker_link(&full, start)) *size = full.out_buffer.size;
+
+    ph_linker_free(&full);
+
+    return 0;
+}
+
+int ph_linker_link(PHLinker *linker, char *start) {
+    PHObject obj;
+    PHInput *input;
+
+    size_t pos;
+    size_t size;
+    size_t start_bytes;
+    size_t start_block = 0;
+    size_t header = 0;
+    size_t full_size = 0;
+    size_t i, n;
+
+    /* Search all labels */
+    for(i=0;i<linker->input_count;i++){
+        input = linker->inputs+i;
+
+        for(pos=0;pos<input->size;pos+=obj.size){
+            if(ph_linker_read(linker, &obj, input, pos)) return 1;
+
+            if(ph_linker_grow((void**)&linker->objects, &linker->object_max,
+                              linker->object_count, sizeof(PHObject))){
+                linker->error = PH_LINK_E_INTERNAL;
+                return 1;
+            }
+            linker->objects[linker->object_count++] = obj;
+
+            if(ph_linker_add_object(linker, i)) return 1;
+        }
+    }
+
+    if(!linker->block_count) return 0;
+
+    if(ph_linker_resolve(linker)) return 1;
+
+    n = ph_symtab_find(&linker->labels, start, strlen(start));
+    if(n < linker->labels.count) start_block = linker->labels.symbols[n].pos;
+
+    if(linker->gc){
+        if(ph_linker_mark(linker, start_block)) return 1;
+
+        for(i=0;i<linker->block_count && linker->blocks[i].reachable;i++);
+        if(i < linker->block_count &&
+           ph_linker_full_size(linker, start, &full_size)){
+            return 1;
+        }
+    }
+
+    /* Count the uses of the strings, and pool the ones used often enough */
+    size = 0;
+    for(i=0;i<linker->block_count;i++){
+        PHBlock *block = linker->blocks+i;
+
+        if(!block->reachable) continue;
+
+        if(ph_linker_pack(linker, block, PH_PACK_COUNT)) return 1;
+        size += block->end-block->start;
+    }
+
+    /* The slots of the variables are a single byte */
+    if(linker->vars.count > PH_VAR_MAX){
+        linker->error = PH_LINK_E_TOO_MANY_VARS;
+        return 1;
+    }
+
+    /* Build the dictionary from the text of the reachable blocks, to compress
+     * all of them */
+    if(linker->compress){
+        for(i=0;i<linker->block_count;i++){
+            if(linker->blocks[i].reachable &&
+               ph_linker_pack(linker, linker->blocks+i, PH_PACK_SAMPLE)){
+                return 1;
+            }
+        }
+
+        if(ph_dict_build(&linker->dict, &linker->scratch)){
+            linker->error = PH_LINK_E_INTERNAL;
+            return 1;
+        }
+
+        header = ph_dict_size(&linker->dict);
+    }
+
+    /* The width of the screen comes before the dictionary */
+    if(linker->layout) header += 2;
+
+    if(ph_linker_pool(linker, ph_linker_offset_size(size))){
+        linker->error = PH_LINK_E_INTERNAL;
+        return 1;
+    }
+
+    /* Without compression, only the blocks using pooled strings, case tables
+     * or variables need to be packed */
+    for(i=0;i<linker->block_count;i++){
+        PHBlock *block = linker->blocks+i;
+
+        if(!linker->compress && block->reachable &&
+           ph_linker_pack(linker, block, PH_PACK_FIND)){
+            return 1;
+        }
+    }
+
+    /* The size of the packed blocks is needed to lay them out */
+    for(i=0;i<linker->block_count;i++){
+        PHBlock *block = linker->blocks+i;
+
+        if(block->reachable &&
+           (linker->compress || linker->layout || block->pack) &&
+           ph_linker_pack(linker, block, PH_PACK_WRITE)){
+            return 1;
+        }
+    }
+
+    /* Size of the payload of the blocks in the output */
+    for(i=0;i<linker->block_count;i++){
+        PHBlock *block = linker->blocks+i;
+
+        if(block->packed == PH_LINK_NONE){
+            block->size = block->end-block->start;
+        }
+
+        /* Only the first block of an object has no label */
+        if(!block->reachable && i && block->obj == block[-1].obj){
+            linker->gc_labels++;
+        }
+    }
+
+    size = ph_linker_layout(linker);
+
+    if(ph_buffer_reserve(&linker->out_buffer,
+                         header+5+linker->pool.size+size)){
+        linker->error = PH_LINK_E_INTERNAL;
+        return 1;
+    }
+
+    /* The width of the screen and the dictionary come first, so that the
+     * engine can find them */
+    if(linker->layout){
+        ph_buffer_putc(&linker->out_buffer, PH_CMD_LINE);
+        ph_buffer_putc(&linker->out_buffer, linker->layout);
+    }
+    if(linker->compress){
+        ph_dict_write(&linker->dict, &linker->out_buffer);
+    }
+
+    /* Start the output file with a goto to the start label if needed, the
+     * pool is between the goto and the blocks */
+
+    start_bytes = header;
+    pos = linker->pool.size+linker->blocks[start_block].pos;
+    if(pos >= 0x20000000){
+        linker->error = PH_LINK_E_TOO_FAR;
+        return 1;
+    }
+    if(pos){
+        /* The offset is relative to the end of the goto */
+        ph_buffer_putc(&linker->out_buffer, PH_CMD_GOTO);
+        ph_linker_put_offset(linker, pos, ph_linker_offset_size(pos));
+
+        start_bytes += 1+ph_linker_offset_size(pos);
+    }
+
+    ph_buffer_write(&linker->out_buffer, linker->pool.data, linker->pool.size);
+    start_bytes += linker->pool.size;
+
+    /* Copy the blocks */
+    for(i=0;i<linker->block_count;i++){
+        PHBlock *block = linker->blocks+i;
+        PHObject *obj = linker->objects+block->obj;
+
+        input = linker->inputs+block->input;
+
+        if(block->reachable){
+            if(ph_linker_copy(linker, block, input, start_bytes)) return 1;
+        }
+
+        if(i+1 == linker->block_count || block[1].obj != block->obj){
+            /* Don't keep both the input and the output in memory, the
+             * blocks are copied in the order of the inputs */
+            ph_input_release(input,
+                             obj->payload+obj->payload_size-input->data);
+        }
+    }
+
+    ph_buffer_shrink(&linker->out_buffer);
+
+    if(full_size == PH_LINK_NONE){
+        linker->gc_bytes = PH_LINK_NONE;
+    }else if(full_size > linker->out_buffer.size){
+        linker->gc_bytes = full_size-linker->out_buffer.size;
     }
 
     return 0;
@@ -353,20 +1383,46 @@ char *ph_linker_get_error(PHLinker *linker) {
         "Success!",
         "Internal error!",
         "Unknown label!",
-        "Duplicate label!"
+        "Duplicate label!",
+        "Invalid object file!",
+        "Unsupported object file version!",
+        "Label too far away!",
+        "Too many cases in a row!",
+        "Too many variables!"
     };
-    static char buffer[64];
+    static char buffer[64+PH_CONV_TOKEN_MAX];
 
-    if(linker->error != PH_LINK_E_DUPLICATE_LABEL){
-        return errors[linker->error];
-    }else{
-        sprintf(buffer, "%s Label `%s' redefined!", errors[linker->error],
-                linker->infostr);
+    if(linker->error == PH_LINK_E_DUPLICATE_LABEL){
+        sprintf(buffer, "%s Label `%.*s' redefined!", errors[linker->error],
+                PH_CONV_TOKEN_MAX-1, linker->infostr);
         return buffer;
+    }else if(linker->error == PH_LINK_E_UNKNOWN_LABEL){
+        sprintf(buffer, "%s Label `%.*s' is not defined!",
+                errors[linker->error], PH_CONV_TOKEN_MAX-1, linker->infostr);
+        return buffer;
+    }else{
+        return errors[linker->error];
     }
 }
 
 void ph_linker_free(PHLinker *linker) {
-    ph_buffer_free(&linker->in_buffer);
+    size_t i;
+
+    for(i=0;i<linker->input_count;i++){
+        ph_input_close(linker->inputs+i);
+    }
+    free(linker->inputs);
+    free(linker->objects);
+    free(linker->blocks);
+    free(linker->refs);
+
+    ph_symtab_free(&linker->labels);
+    ph_arena_free(&linker->scratch);
+    ph_dict_free(&linker->dict);
+    ph_buffer_free(&linker->packed);
+    ph_buffer_free(&linker->pool);
+    ph_symtab_free(&linker->pool_names);
+    ph_symtab_free(&linker->pool_texts);
+    ph_symtab_free(&linker->vars);
     ph_buffer_free(&linker->out_buffer);
 }
@@ -40,24 +40,131 @@
 #include <buffer.h>
 
 #include <commandproperties.h>
+#include <dict.h>
+#include <input.h>
+#include <object.h>
+#include <symtab.h>
 
 #include <stdio.h>
 
+/* Reference to a label or to a string of the pool inserted in a block */
 typedef struct {
-    char *name;
+    /* Block that starts at the label, or offset of the string in the pool */
+    size_t target;
+    /* Offset in the payload of the block, and size of the encoded offset,
+     * which only grows while the output is laid out */
+    size_t offset;
+    unsigned char size;
+    unsigned char pool;
+} PHRef;
+
+/* Part of an object that starts at a label, or at the start of the object, and
+ * ends at the next label. The blocks that can't be reached are removed when
+ * garbage collecting labels. */
+typedef struct {
+    size_t input;
+    size_t obj;
+
+    /* Part of the payload */
+    size_t start;
+    size_t end;
+
+    /* Relocations inserted in this part of the payload */
+    size_t reloc_start;
+    size_t reloc_end;
+
+    /* References to the labels, followed by the ones to the pool once the
+     * block is packed */
+    size_t refs;
+    size_t ref_count;
+
+    /* Position in the output and size of the payload in it */
     size_t pos;
-} PHLabel;
+    size_t size;
+
+    /* Compressed payload in the packed buffer of the linker, PH_LINK_NONE if
+     * the payload is copied from the input */
+    size_t packed;
+
+    /* The engine can run into this block from the previous one */
+    unsigned char fallthrough;
+    /* The payload ends with text, that goes on in the next block if the
+     * engine runs into it */
+    unsigned char text_end;
+    unsigned char reachable;
+    /* The block has to be packed even without compression or layout: some of
+     * its strings are in the pool, or it has cases or variables */
+    unsigned char pack;
+} PHBlock;
+
+#define PH_LINK_NONE ((size_t)-1)
 
 typedef struct {
-    PHLabel *labels;
-    PHArena names;
+    /* The position of the labels is the index of their block */
+    PHSymtab labels;
+
+    /* Temporary arrays of the steps of a link */
+    PHArena scratch;
+
+    /* The input files are mapped or read separately and are never copied */
+    PHInput *inputs;
+    size_t input_count;
+    size_t input_max;
+
+    PHObject *objects;
+    size_t object_count;
+    size_t object_max;
+
+    PHBlock *blocks;
+    size_t block_count;
+    size_t block_max;
+
+    PHRef *refs;
+    size_t ref_count;
+    size_t ref_max;
 
-    PHBuffer in_buffer;
     PHBuffer out_buffer;
 
     PHCommands *commands;
 
-    size_t label_count;
+    /* Only keep the blocks that can be reached from the start label */
+    unsigned char gc;
+    /* How much smaller the output gets, PH_LINK_NONE if it can't be linked
+     * with all the labels, and number of labels removed */
+    size_t gc_bytes;
+    size_t gc_labels;
+
+    /* Compress the text of the reachable blocks */
+    unsigned char compress;
+    PHDict dict;
+    PHBuffer packed;
+    /* Size of the text before and after compression */
+    size_t text_bytes;
+    size_t packed_bytes;
+
+    /* Width of the screen the text is laid out for, 0 to let the engine lay
+     * it out */
+    unsigned char layout;
+    /* Number of lines laid out */
+    size_t lines;
+    /* The block being packed is between a startverbatim and an endverbatim,
+     * the engine doesn't wrap this text */
+    unsigned char verbatim;
+
+    /* Case names, and text runs used more than once, are stored once in the
+     * pool, which comes before the blocks. The position of the strings is
+     * their number of uses until they are pooled, their offset in the pool
+     * after, or PH_LINK_NONE if they aren't worth pooling. */
+    PHSymtab pool_names;
+    PHSymtab pool_texts;
+    PHBuffer pool;
+    size_t pool_count;
+    /* Size of the copies of the pooled strings */
+    size_t pooled_bytes;
+
+    /* Names of the variables, the position of each one is its slot */
+    PHSymtab vars;
+
     int error;
 
     unsigned char *infostr;
@@ -69,12 +176,19 @@ enum {
     PH_LINK_E_INTERNAL,
     PH_LINK_E_UNKNOWN_LABEL,
     PH_LINK_E_DUPLICATE_LABEL,
+    PH_LINK_E_INVALID_OBJECT,
+    PH_LINK_E_OBJECT_VERSION,
+    PH_LINK_E_TOO_FAR,
+    PH_LINK_E_TOO_MANY_CASES,
+    PH_LINK_E_TOO_MANY_VARS,
 
     PH_LINK_E_AMOUNT
 };
 
 int ph_linker_init(PHLinker *linker, PHCommands *commands);
 int ph_linker_add_file(PHLinker *linker, FILE *in);
+int ph_linker_add_mem(PHLinker *linker, const unsigned char *data,
+                      size_t size);
 int ph_linker_link(PHLinker *linker, char *start);
 char *ph_linker_get_error(PHLinker *linker);
 void ph_linker_free(PHLinker *linker);
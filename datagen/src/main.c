@@ -33,54 +33,83 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdlib.h>
 
 #include <string.h>
+#include <time.h>
 
 #include <getopt.h>
+#include <dirent.h>
+#include <unistd.h>
 
+#include <arena.h>
 #include <conv.h>
+#include <elfobj.h>
 #include <link.h>
+#include <jobs.h>
+#include <watch.h>
 
 #include <commands.h>
 
+#include <format.h>
+
 static const char help_str[] = (
-    "USAGE: %s [-clh] [-o OUTPUT_FILE] [-s START_LABEL] [INPUT_FILES...]\n"
+    "USAGE: %s [-clh] [--gc-labels] [--compress] [--layout WIDTH] "
+    "[--watch DIR] [--elf NAME] [-j JOBS] [-C CACHE_DIR] [-o OUTPUT_FILE] "
+    "[-s START_LABEL] [INPUT_FILES...]\n"
     "Phosphore Engine data conversion tool\n"
     "\n"
     "Options:\n"
     "  -c   Compile\n"
     "  -l   Link\n"
+    "  -j   Number of files compiled in parallel (0: one per CPU)\n"
+    "  -C   Reuse the compiled files stored in the cache directory\n"
     "  -o   Specify the output file\n"
     "  -s   Specify the starting label\n"
     "  -h   Show this help message\n"
 );
 
+static const char long_help_str[] =
+    "  --gc-labels  Drop the labels unreachable from the start\n"
+    "  --compress   Compress the text\n"
+    "  --layout     Cut the text in lines like the engine wraps it at WIDTH\n"
+    "  --watch      Compile and link the input files (by default the .txt\n"
+    "               files of DIR, also the ones created later) each time a\n"
+    "               file of DIR is written\n"
+    "  --elf        Output a RISC-V ELF object, where the data is NAME and\n"
+    "               its size is NAME_len\n";
+
 static FILE *in;
 static FILE *out;
 
-static PHConv conv;
 static PHLinker linker;
+static PHJobs jobs;
+static PHBuffer elf;
 
-static void compile_file(char *argv0, char *in_path, char *out_path,
-                        unsigned char compiled_file) {
-    if(strcmp(in_path, "-")){
-        in = fopen(in_path, "rb");
-        if(in == NULL){
-            fprintf(stderr, "%s: Failed to open %s!\n", argv0, in_path);
+/* Without an output file the objects are added to the linker, they stay in
+ * the jobs until they get freed */
+static void compile_files(char *argv0, char **in_paths, size_t count,
+                          char *out_path, size_t threads, char *cache_path) {
+    PHCache cache;
+    size_t hits = 0;
+    size_t i;
 
-            exit(EXIT_FAILURE);
-        }
-    }else{
-        in = stdin;
+    if(cache_path != NULL && ph_cache_init(&cache, cache_path)){
+        fprintf(stderr, "%s: Failed to create the cache directory %s!\n",
+                argv0, cache_path);
+
+        exit(EXIT_FAILURE);
     }
 
-    if(strcmp(out_path, "-")){
-        out = fopen(out_path, compiled_file ? "ab" : "wb");
+    if(out_path == NULL){
+        out = NULL;
+    }else if(strcmp(out_path, "-")){
+        out = fopen(out_path, "wb");
         if(out == NULL){
             fprintf(stderr, "%s: Failed to open %s!\n", argv0, out_path);
-            if(strcmp(in_path, "-")) fclose(in);
 
             exit(EXIT_FAILURE);
         }
@@ -88,39 +117,73 @@ static void compile_file(char *argv0, char *in_path, char *out_path,
         out = stdout;
     }
 
-    if(ph_conv_init(&conv, &ph_commands, NULL)){
+    if(ph_jobs_init(&jobs, &ph_commands, cache_path != NULL ? &cache : NULL,
+                    in_paths, count, threads)){
         fprintf(stderr, "%s: Internal error!\n", argv0);
-        if(strcmp(in_path, "-")) fclose(in);
-        if(strcmp(out_path, "-")) fclose(out);
+        if(out != NULL && out != stdout) fclose(out);
 
         exit(EXIT_FAILURE);
     }
 
-    if(ph_conv_convert(&conv, in)){
-        fprintf(stderr, "%s:%lu: Error: %s\n", in_path, conv.line,
-                ph_conv_get_error(&conv));
+    /* Write the converted files in the order they were given */
+    for(i=0;i<count;i++){
+        PHJob *job = ph_jobs_wait(&jobs, i);
 
-        if(strcmp(in_path, "-")) fclose(in);
-        if(strcmp(out_path, "-")) fclose(out);
+        if(!job->opened){
+            fprintf(stderr, "%s: Failed to open %s!\n", argv0, job->path);
+            if(out != NULL && out != stdout) fclose(out);
+
+            exit(EXIT_FAILURE);
+        }
+        if(job->error){
+            fprintf(stderr, "%s:%lu: Error: %s\n", job->path,
+                    (unsigned long)job->line, job->message);
+            if(out != NULL && out != stdout) fclose(out);
+
+            exit(EXIT_FAILURE);
+        }
 
-        ph_conv_free(&conv);
+        if(job->cached) hits++;
 
-        exit(EXIT_FAILURE);
+        if(out == NULL){
+            if(ph_linker_add_mem(&linker, job->buffer.data,
+                                 job->buffer.size)){
+                fprintf(stderr, "%s: Internal error!\n", argv0);
+
+                exit(EXIT_FAILURE);
+            }
+
+            continue;
+        }
+
+        fwrite(job->buffer.data, 1, job->buffer.size, out);
+
+        ph_jobs_release(&jobs, i);
     }
 
-    fwrite(conv.buffer.data, 1, conv.buffer.size, out);
-    if(strcmp(in_path, "-")) fclose(in);
-    if(strcmp(out_path, "-")) fclose(out);
+    if(out != NULL){
+        if(out != stdout) fclose(out);
+
+        ph_jobs_free(&jobs);
+    }
 
-    ph_conv_free(&conv);
+    if(cache_path != NULL){
+        fprintf(stderr, "%s: Cache: %lu hits, %lu misses\n", argv0,
+                (unsigned long)hits, (unsigned long)(count-hits));
+    }
 }
 
-static void link_start(char *argv0) {
+static void link_start(char *argv0, unsigned char gc,
+                       unsigned char compress, unsigned char layout) {
     if(ph_linker_init(&linker, &ph_commands)){
         fprintf(stderr, "%s: Internal error!\n", argv0);
 
         exit(EXIT_FAILURE);
     }
+
+    linker.gc = gc;
+    linker.compress = compress;
+    linker.layout = layout;
 }
 
 static void link_add_file(char *argv0, char *in_path) {
@@ -137,7 +200,7 @@ static void link_add_file(char *argv0, char *in_path) {
     }
 
     if(ph_linker_add_file(&linker, in)){
-        fprintf(stderr, "%s: Internal error!\n", argv0);
+        fprintf(stderr, "%s: Failed to read %s!\n", argv0, in_path);
         ph_linker_free(&linker);
         if(strcmp(in_path, "-")) fclose(in);
 
@@ -147,7 +210,26 @@ static void link_add_file(char *argv0, char *in_path) {
     if(strcmp(in_path, "-")) fclose(in);
 }
 
-static void link_end(char *argv0, char *out_path, char *start_label) {
+/* Returns the linked data, or the ELF object containing it */
+static PHBuffer *link_output(char *argv0, char *elf_name) {
+    if(elf_name == NULL) return &linker.out_buffer;
+
+    if(ph_buffer_init(&elf, 64) ||
+       ph_elf_write(&elf, linker.out_buffer.data, linker.out_buffer.size,
+                    elf_name)){
+        fprintf(stderr, "%s: Internal error!\n", argv0);
+        ph_linker_free(&linker);
+
+        exit(EXIT_FAILURE);
+    }
+
+    return &elf;
+}
+
+static void link_end(char *argv0, char *out_path, char *start_label,
+                     char *elf_name) {
+    PHBuffer *out_buffer;
+
     if(ph_linker_link(&linker, start_label)){
         fprintf(stderr, "%s: Error: %s\n", argv0,
                 ph_linker_get_error(&linker));
@@ -155,6 +237,8 @@ static void link_end(char *argv0, char *out_path, char *start_label) {
         exit(EXIT_FAILURE);
     }
 
+    out_buffer = link_output(argv0, elf_name);
+
     if(strcmp(out_path, "-")){
         out = fopen(out_path, "wb");
         if(out == NULL){
@@ -163,13 +247,359 @@ static void link_end(char *argv0, char *out_path, char *start_label) {
 
             exit(EXIT_FAILURE);
         }
+    }else{
+        out = stdout;
     }
 
-    fwrite(linker.out_buffer.data, 1, linker.out_buffer.size, out);
+    fwrite(out_buffer->data, 1, out_buffer->size, out);
 
     if(strcmp(out_path, "-")) fclose(out);
 
+    if(elf_name != NULL) ph_buffer_free(&elf);
+
+    if(linker.gc && linker.gc_bytes == PH_LINK_NONE){
+        fprintf(stderr, "%s: Removed %lu unreachable labels\n", argv0,
+                (unsigned long)linker.gc_labels);
+    }else if(linker.gc){
+        fprintf(stderr, "%s: Removed %lu unreachable labels (%lu bytes)\n",
+                argv0, (unsigned long)linker.gc_labels,
+                (unsigned long)linker.gc_bytes);
+    }
+    if(linker.compress){
+        fprintf(stderr, "%s: Compressed %lu bytes of text to %lu bytes "
+                "(%lu byte dictionary)\n", argv0,
+                (unsigned long)linker.text_bytes,
+                (unsigned long)linker.packed_bytes,
+                (unsigned long)ph_dict_size(&linker.dict));
+    }
+    if(linker.layout){
+        fprintf(stderr, "%s: Laid out %lu lines for a width of %u chars\n",
+                argv0, (unsigned long)linker.lines, linker.layout);
+    }
+    if(linker.pool_count){
+        fprintf(stderr, "%s: Pooled %lu strings (%lu bytes of copies in a "
+                "%lu byte pool)\n", argv0, (unsigned long)linker.pool_count,
+                (unsigned long)linker.pooled_bytes,
+                (unsigned long)linker.pool.size);
+    }
+
+    ph_linker_free(&linker);
+}
+
+/* A file compiled in watch mode, its object stays in memory */
+typedef struct {
+    char *path;
+    char *name;
+    PHBuffer obj;
+    unsigned char ok;
+    unsigned char changed;
+} WatchFile;
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+static int cmp_paths(const void *a, const void *b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/* Lists the .txt files of dir in alphabetical order */
+static char **list_files(char *argv0, char *dir, PHArena *arena,
+                         size_t *count) {
+    PHBuffer paths;
+    DIR *dp;
+    struct dirent *entry;
+    char *path;
+
+    dp = opendir(dir);
+    if(dp == NULL){
+        fprintf(stderr, "%s: Failed to open %s!\n", argv0, dir);
+        exit(EXIT_FAILURE);
+    }
+
+    if(ph_buffer_init(&paths, 64*sizeof(char*))){
+        fprintf(stderr, "%s: Internal error!\n", argv0);
+        exit(EXIT_FAILURE);
+    }
+
+    while((entry = readdir(dp)) != NULL){
+        size_t len = strlen(entry->d_name);
+
+        if(len <= 4 || strcmp(entry->d_name+len-4, ".txt")) continue;
+
+        path = ph_arena_alloc(arena, 1, strlen(dir)+len+2);
+        if(path == NULL ||
+           ph_buffer_write(&paths, (unsigned char*)&path, sizeof(char*))){
+            fprintf(stderr, "%s: Internal error!\n", argv0);
+            exit(EXIT_FAILURE);
+        }
+        sprintf(path, "%s/%s", dir, entry->d_name);
+    }
+
+    closedir(dp);
+
+    *count = paths.size/sizeof(char*);
+    qsort(paths.data, *count, sizeof(char*), cmp_paths);
+
+    /* The list is freed with free, the paths stay in the arena */
+    return (char**)paths.data;
+}
+
+static int watch_convert(char *argv0, PHConv *conv, WatchFile *file) {
+    FILE *fp;
+
+    file->ok = 0;
+
+    fp = fopen(file->path, "rb");
+    if(fp == NULL){
+        fprintf(stderr, "%s: Failed to open %s!\n", argv0, file->path);
+        return 1;
+    }
+
+    ph_conv_convert(conv, fp);
+    fclose(fp);
+
+    if(conv->error){
+        fprintf(stderr, "%s:%lu: Error: %s\n", file->path,
+                (unsigned long)conv->line, ph_conv_get_error(conv));
+        return 1;
+    }
+
+    ph_buffer_truncate(&file->obj, 0);
+    if(ph_buffer_write(&file->obj, conv->buffer.data, conv->buffer.size)){
+        fprintf(stderr, "%s: Internal error!\n", argv0);
+        return 1;
+    }
+
+    file->ok = 1;
+
+    return 0;
+}
+
+/* Makes the list of the files compiled in watch mode from their paths. The
+ * files that were already in the old list keep their object, the new ones
+ * get compiled. */
+static WatchFile *watch_list(char *argv0, PHArena *arena, char **paths,
+                             size_t count, WatchFile *old,
+                             size_t old_count) {
+    WatchFile *files;
+    size_t i, n;
+
+    files = ph_arena_alloc(arena, sizeof(WatchFile), count);
+    if(files == NULL){
+        fprintf(stderr, "%s: Internal error!\n", argv0);
+        exit(EXIT_FAILURE);
+    }
+
+    for(i=0;i<count;i++){
+        files[i].path = paths[i];
+        files[i].name = strrchr(paths[i], '/');
+        files[i].name = files[i].name != NULL ? files[i].name+1 : paths[i];
+
+        for(n=0;n<old_count && strcmp(old[n].name, files[i].name);n++);
+        if(n < old_count){
+            files[i].obj = old[n].obj;
+            files[i].ok = old[n].ok;
+            files[i].changed = old[n].changed;
+            continue;
+        }
+
+        files[i].changed = 1;
+        if(ph_buffer_init(&files[i].obj, 64)){
+            fprintf(stderr, "%s: Internal error!\n", argv0);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Free the objects of the files that are not listed anymore */
+    for(n=0;n<old_count;n++){
+        for(i=0;i<count && strcmp(old[n].name, files[i].name);i++);
+        if(i == count) ph_buffer_free(&old[n].obj);
+    }
+
+    return files;
+}
+
+/* Links the objects in memory, and only writes the part of the output that
+ * changed since the last link. Returns 1 if the objects could not be linked,
+ * and sets written to the number of bytes written. */
+static int watch_link(char *argv0, WatchFile *files, size_t count,
+                      char *out_path, char *start_label, char *elf_name,
+                      PHBuffer *image, unsigned char gc,
+                      unsigned char compress, unsigned char layout,
+                      size_t *written) {
+    PHBuffer *out_buffer;
+    size_t same;
+    size_t i;
+
+    link_start(argv0, gc, compress, layout);
+
+    for(i=0;i<count;i++){
+        if(ph_linker_add_mem(&linker, files[i].obj.data, files[i].obj.size)){
+            fprintf(stderr, "%s: Internal error!\n", argv0);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(ph_linker_link(&linker, start_label)){
+        fprintf(stderr, "%s: Error: %s\n", argv0,
+                ph_linker_get_error(&linker));
+        ph_linker_free(&linker);
+        return 1;
+    }
+
+    out_buffer = link_output(argv0, elf_name);
+
+    for(same=0;same < image->size && same < out_buffer->size &&
+               image->data[same] == out_buffer->data[same];same++);
+
+    if(same < image->size || same < out_buffer->size){
+        out = NULL;
+        if(image->size) out = fopen(out_path, "r+b");
+        if(out == NULL){
+            out = fopen(out_path, "wb");
+            same = 0;
+        }
+        if(out == NULL){
+            fprintf(stderr, "%s: Failed to open %s!\n", argv0, out_path);
+            exit(EXIT_FAILURE);
+        }
+
+        fseek(out, same, SEEK_SET);
+        fwrite(out_buffer->data+same, 1, out_buffer->size-same, out);
+        fflush(out);
+        if(out_buffer->size < image->size &&
+           ftruncate(fileno(out), out_buffer->size)){
+            fprintf(stderr, "%s: Failed to truncate %s!\n", argv0,
+                    out_path);
+        }
+        fclose(out);
+    }
+
+    ph_buffer_truncate(image, 0);
+    if(ph_buffer_write(image, out_buffer->data, out_buffer->size)){
+        fprintf(stderr, "%s: Internal error!\n", argv0);
+        exit(EXIT_FAILURE);
+    }
+
+    if(elf_name != NULL) ph_buffer_free(&elf);
     ph_linker_free(&linker);
+
+    *written = image->size-same;
+
+    return 0;
+}
+
+/* Compiles and links the input files, and does it again for the files that
+ * are written in dir. The objects stay in memory, so only the files that
+ * changed are compiled again. Without input files, the .txt files of dir are
+ * listed again each time a file is written. */
+static void watch_files(char *argv0, char *dir, char **in_paths,
+                        size_t count, char *out_path, char *start_label,
+                        char *elf_name, unsigned char gc,
+                        unsigned char compress, unsigned char layout) {
+    PHWatch watch;
+    PHArena arena;
+    PHBuffer image;
+    PHConv conv;
+    WatchFile *files;
+    char *name;
+    double start;
+    size_t written;
+    unsigned char changed;
+    unsigned char scan = 0;
+    size_t i;
+
+    if(!strcmp(out_path, "-")){
+        fprintf(stderr, "%s: Watch mode needs an output file!\n", argv0);
+        exit(EXIT_FAILURE);
+    }
+
+    if(ph_watch_init(&watch, dir)){
+        fprintf(stderr, "%s: Failed to watch %s!\n", argv0, dir);
+        exit(EXIT_FAILURE);
+    }
+
+    if(ph_arena_init(&arena, 4096) || ph_buffer_init(&image, 64) ||
+       ph_conv_init(&conv, &ph_commands, NULL)){
+        fprintf(stderr, "%s: Internal error!\n", argv0);
+        exit(EXIT_FAILURE);
+    }
+
+    if(!count){
+        scan = 1;
+        in_paths = list_files(argv0, dir, &arena, &count);
+    }
+    if(!count){
+        fprintf(stderr, "%s: No input files!\n", argv0);
+        exit(EXIT_FAILURE);
+    }
+
+    files = watch_list(argv0, &arena, in_paths, count, NULL, 0);
+    if(scan) free(in_paths);
+
+    do{
+        unsigned char ok = 1;
+
+        start = now();
+
+        for(i=0;i<count;i++){
+            if(files[i].changed){
+                watch_convert(argv0, &conv, files+i);
+                files[i].changed = 0;
+            }
+            ok &= files[i].ok;
+        }
+
+        /* Wait until all the files can be compiled again */
+        if(ok && !watch_link(argv0, files, count, out_path, start_label,
+                             elf_name, &image, gc, compress, layout,
+                             &written)){
+            fprintf(stderr, "%s: Linked %s in %.2f ms (%lu of %lu bytes "
+                    "written)\n", argv0, out_path, (now()-start)*1000,
+                    (unsigned long)written, (unsigned long)image.size);
+        }
+
+        /* Wait for an input file to be written, and for the other files
+         * written at the same time */
+        changed = 0;
+        while(!changed){
+            name = ph_watch_next(&watch, 1);
+            if(name == NULL){
+                fprintf(stderr, "%s: Failed to watch %s!\n", argv0, dir);
+                exit(EXIT_FAILURE);
+            }
+            while(name != NULL){
+                size_t len = strlen(name);
+
+                for(i=0;i<count && strcmp(files[i].name, name);i++);
+                if(i < count){
+                    files[i].changed = 1;
+                    changed = 1;
+                }else if(scan && len > 4 && !strcmp(name+len-4, ".txt")){
+                    /* A new file was created in dir */
+                    changed = 1;
+                }
+                name = ph_watch_next(&watch, 0);
+            }
+        }
+
+        /* List the files of dir again, to add the new files and remove
+         * the deleted ones */
+        if(scan){
+            size_t new_count;
+
+            in_paths = list_files(argv0, dir, &arena, &new_count);
+            files = watch_list(argv0, &arena, in_paths, new_count, files,
+                               count);
+            count = new_count;
+            free(in_paths);
+        }
+    }while(1);
 }
 
 int main(int argc, char **argv) {
@@ -178,15 +608,59 @@ int main(int argc, char **argv) {
     unsigned char link = 0;
     unsigned char compile = 0;
 
-    unsigned char compiled_file = 0;
-
     char *out_path = "-";
     char *start_label = "main";
 
-    while((opt = getopt(argc, argv, "hcls:o:")) != -1){
+    long int thread_count = 1;
+    char *cache_path = NULL;
+
+    int gc = 0;
+    int compress = 0;
+    long int layout = 0;
+
+    char *watch_dir = NULL;
+    char *elf_name = NULL;
+
+    static const struct option long_options[] = {
+        {"gc-labels", no_argument, NULL, 'g'},
+        {"compress", no_argument, NULL, 'z'},
+        {"watch", required_argument, NULL, 'w'},
+        {"elf", required_argument, NULL, 'e'},
+        {"layout", required_argument, NULL, 'W'},
+        {NULL, 0, NULL, 0}
+    };
+
+    while((opt = getopt_long(argc, argv, "hclj:C:s:o:", long_options,
+                             NULL)) != -1){
         switch(opt){
+            case 'g':
+                /* Remove the unreachable labels when linking */
+                gc = 1;
+                break;
+            case 'z':
+                /* Compress the text when linking */
+                compress = 1;
+                break;
+            case 'w':
+                /* Compile and link again when the files change */
+                watch_dir = optarg;
+                break;
+            case 'W':
+                /* Lay the text out when linking */
+                layout = strtol(optarg, NULL, 10);
+                if(layout <= 0 || layout > PH_LINE_MAX){
+                    fprintf(stderr, "%s: The width must be between 1 and "
+                            "%d!\n", argv[0], PH_LINE_MAX);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'e':
+                /* Output an ELF object that can be linked with the game */
+                elf_name = optarg;
+                break;
             case 'h':
                 fprintf(stderr, help_str, argv[0]);
+                fputs(long_help_str, stderr);
                 return EXIT_SUCCESS;
             case 'c':
                 /* Compile */
@@ -196,8 +670,21 @@ int main(int argc, char **argv) {
                 /* Link */
                 link = 1;
                 break;
+            case 'j':
+                /* Number of compilation threads */
+                thread_count = strtol(optarg, NULL, 10);
+                if(thread_count <= 0){
+                    thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+                    if(thread_count <= 0) thread_count = 1;
+                }
+                break;
+            case 'C':
+                /* Compilation cache directory */
+                cache_path = optarg;
+                break;
             case 's':
                 /* Set the start label (for linking) */
+                start_label = optarg;
                 break;
             case 'o':
                 /* Specify the output file */
@@ -206,43 +693,51 @@ int main(int argc, char **argv) {
         }
     }
 
-    if(compile || !(compile^link)){
-        for(;argv[optind];optind++){
-            /* Files to compile */
-
-            char *in_path = argv[optind];
+    if(watch_dir != NULL){
+        watch_files(argv[0], watch_dir, argv+optind, argc-optind, out_path,
+                    start_label, elf_name, gc, compress, layout);
+    }
 
-            compile_file(argv[0], in_path, out_path, compiled_file);
+    if(!(compile^link)){
+        /* Compile and link, the objects are linked from memory */
 
-            compiled_file = 1;
+        if(optind >= argc){
+            fprintf(stderr, "%s: No input files!\n", argv[0]);
+            return EXIT_FAILURE;
         }
 
-        if(!compiled_file){
+        link_start(argv[0], gc, compress, layout);
+
+        compile_files(argv[0], argv+optind, argc-optind, NULL, thread_count,
+                      cache_path);
+
+        link_end(argv[0], out_path, start_label, elf_name);
+
+        ph_jobs_free(&jobs);
+    }else if(compile){
+        /* Files to compile */
+
+        if(optind >= argc){
             fprintf(stderr, "%s: No input files!\n", argv[0]);
             return EXIT_FAILURE;
         }
-    }
 
-    if(link || !(link^compile)){
+        compile_files(argv[0], argv+optind, argc-optind, out_path,
+                      thread_count, cache_path);
+    }else{
         /* Link */
 
-        link_start(argv[0]);
+        link_start(argv[0], gc, compress, layout);
 
-        if(!(link^compile)){
-            /* The input file is the output file */
-            link_add_file(argv[0], out_path);
-        }else{
-            for(;argv[optind];optind++){
-                /* Files to link */
+        for(;argv[optind];optind++){
+            /* Files to link */
 
-                char *in_path = argv[optind];
+            char *in_path = argv[optind];
 
-                link_add_file(argv[0], in_path);
-            }
-            /* Use the output files */
+            link_add_file(argv[0], in_path);
         }
 
-        link_end(argv[0], out_path, start_label);
+        link_end(argv[0], out_path, start_label, elf_name);
     }
 
     return EXIT_SUCCESS;
@@ -0,0 +1,256 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <object.h>
+
+#include <format.h>
+
+#include <string.h>
+
+unsigned long int ph_obj_get32(const unsigned char *data) {
+    return (unsigned long int)data[0]|((unsigned long int)data[1]<<8)|
+           ((unsigned long int)data[2]<<16)|((unsigned long int)data[3]<<24);
+}
+
+int ph_obj_put32(PHBuffer *buffer, unsigned long int n) {
+    unsigned char bytes[4];
+
+    bytes[0] = n&0xFF;
+    bytes[1] = (n>>8)&0xFF;
+    bytes[2] = (n>>16)&0xFF;
+    bytes[3] = (n>>24)&0xFF;
+
+    return ph_buffer_write(buffer, bytes, 4);
+}
+
+/* Checks that a name is a string of the string table, that is shorter than the
+ * tokens of the converter */
+static int ph_obj_check_name(PHObject *obj, unsigned long int name) {
+    const char *end;
+
+    if(name >= obj->strings_size) return 1;
+
+    end = memchr(obj->strings+name, 0, obj->strings_size-name);
+
+    return end == NULL ||
+           (size_t)(end-(obj->strings+name)) >= PH_CONV_TOKEN_MAX;
+}
+
+int ph_obj_read(PHObject *obj, const unsigned char *data, size_t size) {
+    size_t left;
+    size_t i;
+    size_t last = 0;
+
+    if(size < PH_OBJ_HEADER_SIZE) return PH_OBJ_E_TRUNCATED;
+    if(memcmp(data, PH_OBJ_MAGIC, 4)) return PH_OBJ_E_MAGIC;
+
+    obj->version = ph_obj_get32(data+4);
+    if(obj->version != PH_OBJ_VERSION) return PH_OBJ_E_VERSION;
+
+    obj->flags = ph_obj_get32(data+8);
+    obj->payload_size = ph_obj_get32(data+12);
+    obj->label_count = ph_obj_get32(data+16);
+    obj->reloc_count = ph_obj_get32(data+20);
+    obj->strings_size = ph_obj_get32(data+24);
+
+    /* Check that all the tables fit in the object */
+    left = size-PH_OBJ_HEADER_SIZE;
+
+    if(obj->label_count > left/PH_OBJ_LABEL_SIZE) return PH_OBJ_E_TRUNCATED;
+    left -= obj->label_count*PH_OBJ_LABEL_SIZE;
+    if(obj->reloc_count > left/PH_OBJ_RELOC_SIZE) return PH_OBJ_E_TRUNCATED;
+    left -= obj->reloc_count*PH_OBJ_RELOC_SIZE;
+    if(obj->strings_size > left) return PH_OBJ_E_TRUNCATED;
+    left -= obj->strings_size;
+    if(obj->payload_size > left) return PH_OBJ_E_TRUNCATED;
+
+    obj->labels = data+PH_OBJ_HEADER_SIZE;
+    obj->relocs = obj->labels+obj->label_count*PH_OBJ_LABEL_SIZE;
+    obj->strings = (const char*)obj->relocs+
+                   obj->reloc_count*PH_OBJ_RELOC_SIZE;
+    obj->payload = (const unsigned char*)obj->strings+obj->strings_size;
+
+    obj->size = obj->payload+obj->payload_size-data;
+
+    /* Check that all the names are NUL-terminated strings of the string
+     * table, not longer than a token, and that the offsets are in the
+     * payload. */
+    if(obj->strings_size && obj->strings[obj->strings_size-1]){
+        return PH_OBJ_E_INVALID;
+    }
+
+    /* The linker expects the labels and the relocations to be sorted by
+     * offset */
+    for(i=0;i<obj->label_count;i++){
+        const unsigned char *label = obj->labels+i*PH_OBJ_LABEL_SIZE;
+        size_t offset = ph_obj_get32(label+4);
+
+        if(offset > obj->payload_size || offset < last){
+            return PH_OBJ_E_INVALID;
+        }
+        if(ph_obj_check_name(obj, ph_obj_get32(label))){
+            return PH_OBJ_E_INVALID;
+        }
+
+        last = offset;
+    }
+
+    last = 0;
+    for(i=0;i<obj->reloc_count;i++){
+        const unsigned char *reloc = obj->relocs+i*PH_OBJ_RELOC_SIZE;
+        size_t offset = ph_obj_get32(reloc+1);
+
+        if(reloc[0] >= PH_RELOC_AMOUNT) return PH_OBJ_E_INVALID;
+        if(offset > obj->payload_size || offset < last){
+            return PH_OBJ_E_INVALID;
+        }
+        if(ph_obj_check_name(obj, ph_obj_get32(reloc+5))){
+            return PH_OBJ_E_INVALID;
+        }
+
+        last = offset;
+    }
+
+    return PH_OBJ_SUCCESS;
+}
+
+void ph_obj_label(PHObject *obj, size_t i, PHObjLabel *label) {
+    const unsigned char *entry = obj->labels+i*PH_OBJ_LABEL_SIZE;
+
+    label->name = obj->strings+ph_obj_get32(entry);
+    label->offset = ph_obj_get32(entry+4);
+    label->flags = entry[8];
+}
+
+void ph_obj_reloc(PHObject *obj, size_t i, PHObjReloc *reloc) {
+    const unsigned char *entry = obj->relocs+i*PH_OBJ_RELOC_SIZE;
+
+    reloc->kind = entry[0];
+    reloc->offset = ph_obj_get32(entry+1);
+    reloc->name = obj->strings+ph_obj_get32(entry+5);
+}
+
+int ph_obj_writer_init(PHObjWriter *writer) {
+    if(ph_buffer_init(&writer->labels, 64)) return 1;
+    if(ph_buffer_init(&writer->relocs, 64)){
+        ph_buffer_free(&writer->labels);
+        return 1;
+    }
+    if(ph_buffer_init(&writer->strings, 64)){
+        ph_buffer_free(&writer->labels);
+        ph_buffer_free(&writer->relocs);
+        return 1;
+    }
+
+    writer->label_count = 0;
+    writer->reloc_count = 0;
+
+    return 0;
+}
+
+void ph_obj_writer_reset(PHObjWriter *writer) {
+    ph_buffer_truncate(&writer->labels, 0);
+    ph_buffer_truncate(&writer->relocs, 0);
+    ph_buffer_truncate(&writer->strings, 0);
+
+    writer->label_count = 0;
+    writer->reloc_count = 0;
+}
+
+static int ph_obj_add_string(PHObjWriter *writer, const char *str,
+                             size_t len) {
+    if(ph_buffer_write(&writer->strings, (unsigned char*)str, len)) return 1;
+
+    return ph_buffer_putc(&writer->strings, 0);
+}
+
+int ph_obj_add_label(PHObjWriter *writer, const char *name, size_t len,
+                     size_t offset, unsigned char flags) {
+    if(ph_obj_put32(&writer->labels, writer->strings.size)) return 1;
+    if(ph_obj_put32(&writer->labels, offset)) return 1;
+    if(ph_buffer_putc(&writer->labels, flags)) return 1;
+    if(ph_obj_add_string(writer, name, len)) return 1;
+
+    writer->label_count++;
+
+    return 0;
+}
+
+int ph_obj_add_reloc(PHObjWriter *writer, unsigned char kind,
+                     const char *name, size_t len, size_t offset) {
+    if(ph_buffer_putc(&writer->relocs, kind)) return 1;
+    if(ph_obj_put32(&writer->relocs, offset)) return 1;
+    if(ph_obj_put32(&writer->relocs, writer->strings.size)) return 1;
+    if(ph_obj_add_string(writer, name, len)) return 1;
+
+    writer->reloc_count++;
+
+    return 0;
+}
+
+int ph_obj_write(PHObjWriter *writer, const unsigned char *payload,
+                 size_t size, unsigned long int flags, PHBuffer *out) {
+    if(ph_buffer_reserve(out, out->size+PH_OBJ_HEADER_SIZE+
+                         writer->labels.size+writer->relocs.size+
+                         writer->strings.size+size)){
+        return 1;
+    }
+
+    if(ph_buffer_write(out, (unsigned char*)PH_OBJ_MAGIC, 4)) return 1;
+    if(ph_obj_put32(out, PH_OBJ_VERSION)) return 1;
+    if(ph_obj_put32(out, flags)) return 1;
+    if(ph_obj_put32(out, size)) return 1;
+    if(ph_obj_put32(out, writer->label_count)) return 1;
+    if(ph_obj_put32(out, writer->reloc_count)) return 1;
+    if(ph_obj_put32(out, writer->strings.size)) return 1;
+
+    if(ph_buffer_write(out, writer->labels.data, writer->labels.size)){
+        return 1;
+    }
+    if(ph_buffer_write(out, writer->relocs.data, writer->relocs.size)){
+        return 1;
+    }
+    if(ph_buffer_write(out, writer->strings.data, writer->strings.size)){
+        return 1;
+    }
+
+    return ph_buffer_write(out, (unsigned char*)payload, size);
+}
+
+void ph_obj_writer_free(PHObjWriter *writer) {
+    ph_buffer_free(&writer->labels);
+    ph_buffer_free(&writer->relocs);
+    ph_buffer_free(&writer->strings);
+}
@@ -0,0 +1,159 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHOSPHOR_OBJECT_H
+#define PHOSPHOR_OBJECT_H
+
+#include <stddef.h>
+
+#include <buffer.h>
+
+/* Object files generated by the converter.
+ *
+ * An object is made of a header, a label table, a relocation table, a string
+ * table and the payload, which is the bytecode of the file without the label
+ * definitions and label references. All the numbers are 32 bit little endian
+ * numbers. Multiple objects can be concatenated in a single file.
+ *
+ * Header:
+ *   "PHOB", version, flags, payload size, label count, relocation count,
+ *   string table size
+ * Label:
+ *   name (offset in the string table), offset in the payload, flags (1 byte)
+ * Relocation:
+ *   kind (1 byte), offset in the payload, name (offset in the string table)
+ *
+ * A relocation is inserted by the linker before the byte of the payload it
+ * points to. A label points to a byte of the payload too, but it comes after
+ * the relocations at the same offset, as these are the operands of the
+ * command that precedes the label.
+ */
+
+#define PH_OBJ_VERSION 2
+
+#define PH_OBJ_MAGIC "PHOB"
+#define PH_OBJ_HEADER_SIZE 28
+#define PH_OBJ_LABEL_SIZE 9
+#define PH_OBJ_RELOC_SIZE 9
+
+/* Flags of the objects and of the labels */
+enum {
+    /* The engine can run into the label from the code that precedes it, or
+     * run past the end of the object into the next one. If it isn't set, the
+     * code before it ends with a goto, an ask or a return. */
+    PH_OBJ_FALLTHROUGH = 1
+};
+
+enum {
+    /* 4 byte offset from the end of the reference to the label */
+    PH_RELOC_LABEL,
+
+    PH_RELOC_AMOUNT
+};
+
+typedef struct {
+    const char *name;
+    size_t offset;
+    unsigned char flags;
+} PHObjLabel;
+
+typedef struct {
+    unsigned char kind;
+    size_t offset;
+    const char *name;
+} PHObjReloc;
+
+/* Object file being read. The object is not copied. */
+typedef struct {
+    unsigned long int version;
+    unsigned long int flags;
+
+    const unsigned char *labels;
+    size_t label_count;
+
+    const unsigned char *relocs;
+    size_t reloc_count;
+
+    const char *strings;
+    size_t strings_size;
+
+    const unsigned char *payload;
+    size_t payload_size;
+
+    /* Size of the whole object */
+    size_t size;
+} PHObject;
+
+/* Tables of the object file being written */
+typedef struct {
+    PHBuffer labels;
+    size_t label_count;
+
+    PHBuffer relocs;
+    size_t reloc_count;
+
+    PHBuffer strings;
+} PHObjWriter;
+
+enum {
+    PH_OBJ_SUCCESS,
+
+    PH_OBJ_E_TRUNCATED,
+    PH_OBJ_E_MAGIC,
+    PH_OBJ_E_VERSION,
+    PH_OBJ_E_INVALID,
+
+    PH_OBJ_E_AMOUNT
+};
+
+int ph_obj_read(PHObject *obj, const unsigned char *data, size_t size);
+void ph_obj_label(PHObject *obj, size_t i, PHObjLabel *label);
+void ph_obj_reloc(PHObject *obj, size_t i, PHObjReloc *reloc);
+
+int ph_obj_writer_init(PHObjWriter *writer);
+void ph_obj_writer_reset(PHObjWriter *writer);
+int ph_obj_add_label(PHObjWriter *writer, const char *name, size_t len,
+                     size_t offset, unsigned char flags);
+int ph_obj_add_reloc(PHObjWriter *writer, unsigned char kind,
+                     const char *name, size_t len, size_t offset);
+/* Writes the header and the tables followed by the payload to out. */
+int ph_obj_write(PHObjWriter *writer, const unsigned char *payload,
+                 size_t size, unsigned long int flags, PHBuffer *out);
+void ph_obj_writer_free(PHObjWriter *writer);
+
+unsigned long int ph_obj_get32(const unsigned char *data);
+int ph_obj_put32(PHBuffer *buffer, unsigned long int n);
+
+#endif
@@ -0,0 +1,109 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <scan.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define _PLAIN(c) ((c) > ' ' && (c) < 0x7F && (c) != '#' && (c) != '\\')
+
+size_t ph_scan_plain_scalar(const unsigned char *data, size_t size) {
+    size_t i;
+
+    for(i=0;i<size && _PLAIN(data[i]);i++);
+
+    return i;
+}
+
+size_t ph_scan_plain(const unsigned char *data, size_t size) {
+    size_t i = 0;
+
+    /* NOTE: The comparisons are signed, so bytes above 0x7F are negative and
+     * fail the lower bound check like control chars and spaces. */
+
+#if defined(__AVX2__)
+    const __m256i low = _mm256_set1_epi8(' ');
+    const __m256i high = _mm256_set1_epi8(0x7F);
+    const __m256i hash = _mm256_set1_epi8('#');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+
+    for(;i+32<=size;i+=32){
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data+i));
+        __m256i plain;
+        __m256i special;
+        unsigned int mask;
+
+        plain = _mm256_and_si256(_mm256_cmpgt_epi8(v, low),
+                                 _mm256_cmpgt_epi8(high, v));
+        special = _mm256_or_si256(_mm256_cmpeq_epi8(v, hash),
+                                  _mm256_cmpeq_epi8(v, backslash));
+
+        mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_andnot_si256(special,
+                                                                       plain));
+        if(mask) return i+__builtin_ctz(mask);
+    }
+#endif
+
+#if defined(__SSE2__)
+    {
+        const __m128i low = _mm_set1_epi8(' ');
+        const __m128i high = _mm_set1_epi8(0x7F);
+        const __m128i hash = _mm_set1_epi8('#');
+        const __m128i backslash = _mm_set1_epi8('\\');
+
+        for(;i+16<=size;i+=16){
+            __m128i v = _mm_loadu_si128((const __m128i*)(data+i));
+            __m128i plain;
+            __m128i special;
+            unsigned int mask;
+
+            plain = _mm_and_si128(_mm_cmpgt_epi8(v, low),
+                                  _mm_cmpgt_epi8(high, v));
+            special = _mm_or_si128(_mm_cmpeq_epi8(v, hash),
+                                   _mm_cmpeq_epi8(v, backslash));
+
+            mask = ~_mm_movemask_epi8(_mm_andnot_si128(special, plain))&
+                   0xFFFF;
+            if(mask) return i+__builtin_ctz(mask);
+        }
+    }
+#endif
+
+    return i+ph_scan_plain_scalar(data+i, size-i);
+}
@@ -0,0 +1,159 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <symtab.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <hash.h>
+
+#define PH_SYMTAB_BITS 6
+
+int ph_symtab_init(PHSymtab *symtab) {
+    symtab->count = 0;
+    symtab->max = 0;
+    symtab->symbols = NULL;
+
+    symtab->bits = PH_SYMTAB_BITS;
+    symtab->copy = 1;
+    symtab->slots = calloc((size_t)1<<symtab->bits, sizeof(size_t));
+    if(symtab->slots == NULL) return 1;
+
+    if(ph_arena_init(&symtab->names, 1024)){
+        free(symtab->slots);
+        symtab->slots = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+static size_t ph_symtab_slot(size_t *slots, unsigned char bits,
+                             unsigned long int hash) {
+    size_t mask = ((size_t)1<<bits)-1;
+    size_t i = ph_hash_slot(hash, bits);
+
+    /* Linear probing, the table is never more than 3/4 full */
+    while(slots[i]) i = (i+1)&mask;
+
+    return i;
+}
+
+static int ph_symtab_grow(PHSymtab *symtab) {
+    size_t *slots;
+    unsigned char bits = symtab->bits+1;
+    size_t i;
+
+    slots = calloc((size_t)1<<bits, sizeof(size_t));
+    if(slots == NULL) return 1;
+
+    for(i=0;i<symtab->count;i++){
+        slots[ph_symtab_slot(slots, bits, symtab->symbols[i].hash)] = i+1;
+    }
+
+    free(symtab->slots);
+    symtab->slots = slots;
+    symtab->bits = bits;
+
+    return 0;
+}
+
+size_t ph_symtab_find(PHSymtab *symtab, const char *name, size_t len) {
+    unsigned long int hash = ph_hash_string(0, name, len);
+    size_t mask = ((size_t)1<<symtab->bits)-1;
+    size_t i = ph_hash_slot(hash, symtab->bits);
+
+    for(;symtab->slots[i];i=(i+1)&mask){
+        PHSymbol *symbol = symtab->symbols+symtab->slots[i]-1;
+
+        if(symbol->hash == hash && symbol->len == len &&
+           !memcmp(symbol->name, name, len)){
+            return symtab->slots[i]-1;
+        }
+    }
+
+    return symtab->count;
+}
+
+int ph_symtab_add(PHSymtab *symtab, const char *name, size_t len,
+                  size_t pos) {
+    PHSymbol *symbol;
+
+    if((symtab->count+1)*4 > ((size_t)3<<symtab->bits)){
+        if(ph_symtab_grow(symtab)) return 1;
+    }
+
+    if(symtab->count >= symtab->max){
+        size_t max = symtab->max ? symtab->max*2 : 64;
+        PHSymbol *new;
+
+        new = realloc(symtab->symbols, max*sizeof(PHSymbol));
+        if(new == NULL) return 1;
+
+        symtab->symbols = new;
+        symtab->max = max;
+    }
+
+    symbol = symtab->symbols+symtab->count;
+
+    if(symtab->copy){
+        symbol->name = ph_arena_alloc(&symtab->names, 1, len+1);
+        if(symbol->name == NULL) return 1;
+
+        memcpy(symbol->name, name, len);
+        symbol->name[len] = 0;
+    }else{
+        symbol->name = (char*)name;
+    }
+    symbol->len = len;
+    symbol->hash = ph_hash_string(0, name, len);
+    symbol->pos = pos;
+
+    symtab->slots[ph_symtab_slot(symtab->slots, symtab->bits,
+                                 symbol->hash)] = symtab->count+1;
+    symtab->count++;
+
+    return 0;
+}
+
+void ph_symtab_free(PHSymtab *symtab) {
+    free(symtab->symbols);
+    free(symtab->slots);
+    ph_arena_free(&symtab->names);
+
+    symtab->symbols = NULL;
+    symtab->slots = NULL;
+}
@@ -0,0 +1,82 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHOSPHOR_SYMTAB_H
+#define PHOSPHOR_SYMTAB_H
+
+#include <stddef.h>
+
+#include <arena.h>
+
+/* Open addressing hash table of the labels, used by the linker. The symbols
+ * are kept in definition order in symbols, the slots only index them. */
+
+typedef struct {
+    char *name;
+    size_t len;
+    unsigned long int hash;
+
+    size_t pos;
+} PHSymbol;
+
+typedef struct {
+    PHSymbol *symbols;
+    size_t count;
+    size_t max;
+
+    /* Index of the symbol stored in each slot plus one, 0 if the slot is
+     * empty */
+    size_t *slots;
+    unsigned char bits;
+
+    /* The names are copied to the arena if copy is set, otherwise they
+     * must outlive the table */
+    PHArena names;
+    unsigned char copy;
+} PHSymtab;
+
+int ph_symtab_init(PHSymtab *symtab);
+
+/* Returns the index of the symbol called name, or symtab->count if there is
+ * no such symbol. */
+size_t ph_symtab_find(PHSymtab *symtab, const char *name, size_t len);
+
+/* Adds a symbol without checking if it already exists. Returns 1 on failure.
+ */
+int ph_symtab_add(PHSymtab *symtab, const char *name, size_t len, size_t pos);
+
+void ph_symtab_free(PHSymtab *symtab);
+
+#endif
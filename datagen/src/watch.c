@@ -0,0 +1,112 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <watch.h>
+
+#ifdef __linux__
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+int ph_watch_init(PHWatch *watch, char *dir) {
+    watch->size = 0;
+    watch->pos = 0;
+
+    watch->fd = inotify_init();
+    if(watch->fd < 0) return 1;
+
+    /* Editors either write the files or replace them with a new one */
+    if(inotify_add_watch(watch->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+        close(watch->fd);
+        return 1;
+    }
+
+    return 0;
+}
+
+char *ph_watch_next(PHWatch *watch, unsigned char wait) {
+    while(1){
+        struct inotify_event *event;
+        struct pollfd fd;
+        ssize_t size;
+
+        while(watch->pos < watch->size){
+            event = (struct inotify_event*)((char*)watch->events+
+                                            watch->pos);
+            watch->pos += sizeof(struct inotify_event)+event->len;
+
+            if(event->len) return event->name;
+        }
+
+        fd.fd = watch->fd;
+        fd.events = POLLIN;
+        if(!wait && poll(&fd, 1, 0) <= 0) return NULL;
+
+        size = read(watch->fd, watch->events, sizeof(watch->events));
+        if(size <= 0) return NULL;
+
+        watch->size = size;
+        watch->pos = 0;
+    }
+}
+
+void ph_watch_free(PHWatch *watch) {
+    close(watch->fd);
+}
+
+#else
+
+int ph_watch_init(PHWatch *watch, char *dir) {
+    (void)watch;
+    (void)dir;
+
+    return 1;
+}
+
+char *ph_watch_next(PHWatch *watch, unsigned char wait) {
+    (void)watch;
+    (void)wait;
+
+    return NULL;
+}
+
+void ph_watch_free(PHWatch *watch) {
+    (void)watch;
+}
+
+#endif
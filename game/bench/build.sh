@@ -0,0 +1,117 @@
+#!/bin/bash
+
+# Phosphor Engine: A small but quite special game engine to create text
+#                  adventures.
+#
+# by Mibi88
+#
+# This software is licensed under the BSD-3-Clause license:
+#
+# Copyright 2025 Mibi88
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+#
+# 3. Neither the name of the copyright holder nor the names of its
+# contributors may be used to endorse or promote products derived from this
+# software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+help="USAGE: $0\n"\
+"Builds the engine with the adventure of vm.js and counts the instructions it "\
+"runs for each arithmetic command in the emulator.\n\n"\
+"Needs the datagen tool and the libgcc parts of the game."
+
+cc=clang
+ld=ld.lld
+objcopy=llvm-objcopy
+node=node
+
+# The same flags as a release build of the game
+cflags=(-ansi -ffreestanding --target=riscv32 -march=rv32i -Wall -Wextra \
+        -Wpedantic -Os -I../src -I../../shared)
+ldflags=(-T ../phosphor.x --lto-O3)
+
+builddir=build
+datagen=../../datagen/main
+dataname=ph_data
+
+name=vm
+srcdir=../src
+
+while getopts "h" flag; do
+    case "${flag}" in
+        h) echo -e $help
+           exit 0 ;;
+    esac
+done
+
+rootdir=$(dirname $0)
+orgdir=$(pwd)
+echo "-- Entering $rootdir..."
+cd $rootdir
+
+mkdir -p $builddir
+
+objfiles=()
+
+errorcheck() {
+    rc=$?
+    if [ $rc -ne 0 ]; then
+        echo "-- Build failed with exit code $rc!"
+        echo "-- Exiting $rootdir..."
+        cd $orgdir
+        exit $rc
+    fi
+}
+
+echo "-- Generating $builddir/$name.txt..."
+$node $name.js gen > $builddir/$name.txt
+errorcheck
+
+# The adventure of the benchmark replaces the one of the game
+echo "-- Converting and linking $builddir/$name.txt..."
+$datagen --elf $dataname $builddir/$name.txt -o $builddir/data.o
+errorcheck
+objfiles+=($builddir/data.o)
+
+for i in $(find $srcdir -mindepth 1 -type f \( -name "*.c" -o -name "*.s" \
+           -o -name "*.S" \)); do
+    obj=$builddir/${i#$srcdir*}.o
+    echo "-- Compiling ${i} to ${obj}..."
+    mkdir -p $(dirname $obj)
+    $cc -c $i -o $obj ${cflags[@]}
+    errorcheck
+    objfiles+=($obj)
+done
+
+echo "-- Linking $name..."
+$ld ${objfiles[@]} -o $builddir/$name.elf ${ldflags[@]}
+errorcheck
+
+$objcopy -O binary $builddir/$name.elf $builddir/$name
+errorcheck
+
+$node $name.js run $builddir/$name
+errorcheck
+
+echo "-- Exiting $rootdir..."
+cd $orgdir
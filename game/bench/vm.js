@@ -0,0 +1,203 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Microbenchmark of the arithmetic commands: counts the rv32i instructions the
+ * engine runs for each of them.
+ *
+ * node vm.js gen             prints the adventure of the benchmark
+ * node vm.js run BINARY      runs the engine built with it in the emulator of
+ *                            js/rv.js and prints the results
+ *
+ * Each benchmark is a loop that runs its commands REPEAT times per
+ * iteration. The engine prints a marker char between the benchmarks, the
+ * instructions run by the loop alone are measured by the first one. */
+
+const fs = require("fs");
+const path = require("path");
+const vm = require("vm");
+
+const ITERATIONS = 200;
+const REPEAT = 16;
+const MARKER = 1;
+
+/* The commands of each benchmark leave the stack as they found it */
+const benches = [
+    {name: "loop", cmds: []},
+    {name: "var load", cmds: ["var load x"]},
+    {name: "var store", cmds: ["var store x"]},
+    {name: "var set", cmds: ["var set x 42"]},
+    {name: "var del", cmds: ["var del x"]},
+    {name: "tmp push, tmp pull", cmds: ["tmp push", "tmp pull"]},
+    {name: "tmp load", cmds: ["tmp load"]},
+    {name: "tmp getsp", cmds: ["tmp getsp"]},
+    {name: "tmp push, math add", cmds: ["tmp push", "math add"]},
+    {name: "tmp push, math xor", cmds: ["tmp push", "math xor"]},
+    {name: "tmp push, math mul", cmds: ["tmp push", "math mul"]},
+    {name: "tmp push, math div", cmds: ["tmp push", "math div"]},
+    {name: "tmp push, branch ne (not taken)", cmds: ["tmp push",
+                                                     "branch ne @"]},
+    {name: "tmp push, branch eq (taken)", cmds: ["tmp push", "branch eq @"]},
+    {name: "io getx", cmds: ["io getx"]}
+];
+
+function gen() {
+    var src = [
+        "#label main",
+        "#var set marker " + MARKER,
+        "#var set one 1",
+        "#var set zero 0",
+        "#var set x 7"
+    ];
+    var label = 0;
+
+    for(var i=0;i<benches.length;i++){
+        src.push("#var load marker", "#io putc",
+                 "#var set i " + ITERATIONS, "#label loop" + i);
+
+        for(var n=0;n<REPEAT;n++){
+            for(var cmd of benches[i].cmds){
+                /* The branches go to the next command */
+                if(cmd.endsWith("@")){
+                    src.push("#" + cmd.replace("@", "next" + label));
+                    src.push("#label next" + label);
+                    label++;
+                }else{
+                    src.push("#" + cmd);
+                }
+            }
+        }
+
+        /* Decrement i and loop while it isn't 0 */
+        src.push("#var load i", "#tmp push", "#var load one", "#math sub",
+                 "#var store i", "#tmp push", "#var load zero",
+                 "#branch ne loop" + i);
+    }
+
+    src.push("#var load marker", "#io putc", "#return");
+
+    console.log(src.join("\n"));
+}
+
+function run(file) {
+    const rom = fs.readFileSync(file);
+    const ram = new Uint8Array(1024*1024);
+    /* Size of the terminal of js/main.js */
+    const termW = 80;
+    const termH = 24;
+    const cpu = {};
+    const marks = [];
+    const max = 100000000;
+
+    var cur = [0, 0];
+    var writeTmp = 0;
+    var count = 0;
+
+    /* Load the emulator in the global scope, like the browser does */
+    vm.runInThisContext(fs.readFileSync(path.join(__dirname, "..", "..",
+                                                  "js", "rv.js"), "utf8"));
+
+    function r(rv, addr) {
+        if(addr < 1024*1024) return ram[addr];
+        if(addr >= 1024*1024+16) return rom[addr-(1024*1024+16)]|0;
+
+        switch(addr-1024*1024){
+            case 8: return cur[0]&0xFF;
+            case 9: return cur[0]>>8;
+            case 10: return cur[1]&0xFF;
+            case 11: return cur[1]>>8;
+        }
+        return 0;
+    }
+
+    function w(rv, addr, byte) {
+        var i;
+
+        if(addr < 1024*1024){
+            ram[addr] = byte;
+            return;
+        }
+
+        switch(addr-1024*1024){
+            case 0:
+                if(byte == MARKER) marks.push(count);
+                break;
+            case 8:
+            case 10:
+                writeTmp = byte;
+                break;
+            case 9:
+            case 11:
+                /* The cursor stays on the screen, like in js/term.js */
+                i = (addr-1024*1024-9)/2;
+                cur[i] = Math.min(writeTmp|(byte<<8), (i ? termH : termW)-1);
+                break;
+        }
+    }
+
+    RVInit(cpu, 1024*1024+16, r, w);
+
+    while(marks.length <= benches.length && !cpu.jam && count < max){
+        RVLoadInstr(cpu);
+        RVRunInstr(cpu);
+        count++;
+    }
+
+    if(marks.length <= benches.length){
+        console.log("The benchmark didn't end after " + count +
+                    " instructions!");
+        process.exit(1);
+    }
+
+    const loop = marks[1]-marks[0];
+
+    console.log("Instructions per run of the commands, " + ITERATIONS +
+                " iterations of " + REPEAT + " runs:");
+    console.log("  loop: " + (loop/ITERATIONS).toFixed(1) +
+                " per iteration");
+    for(var i=1;i<benches.length;i++){
+        const n = (marks[i+1]-marks[i]-loop)/(ITERATIONS*REPEAT);
+
+        console.log("  " + benches[i].name + ": " + n.toFixed(1));
+    }
+}
+
+if(process.argv[2] == "gen"){
+    gen();
+}else if(process.argv[2] == "run" && process.argv.length > 3){
+    run(process.argv[3]);
+}else{
+    console.log("USAGE: node vm.js gen | node vm.js run BINARY");
+    process.exit(1);
+}
@@ -102,6 +102,11 @@ for i in $(find $srcdir -mindepth 1 -type f \( -name "*.c" -o -name "*.s" \
     objfiles+=($obj)
 done
 
+# Objects generated by other tools, like the text adventure data
+for i in $(find $srcdir -mindepth 1 -type f -name "*.o"); do
+    objfiles+=($i)
+done
+
 # Linking
 echo "-- Linking $name..."
 $ld ${objfiles[@]} -o $name.elf ${ldflags[@]}
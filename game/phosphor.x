@@ -51,6 +51,7 @@ SECTIONS
     .rodata : {
         *(.rodata)
         *(.rodata.str1.1)
+        *(.rodata.ph_data)
         _romdata_start = . ;
     } > rom
     .bss : {
@@ -104,5 +104,9 @@ int main(void) {
 
     ph_adventure_init(&adv, ph_data);
     ph_adventure_run(&adv);
+
+    /* The adventure ended with a return */
+    while(1);
+
     return 0;
 }
@@ -38,13 +38,42 @@
 
 #include <format.h>
 
-/* TODO: Clean this mess up */
-
-#define _C (adv->data[adv->cur])
+#define _U16(p) ((p)[0]|((p)[1]<<8))
+#define _U32(p) (_U16(p)|((unsigned int)_U16((p)+2)<<16))
 
 void ph_adventure_init(PHAdventure *adv, unsigned char *data) {
+    size_t i;
+
     adv->case_count = 0;
     adv->data = data;
+    adv->cur = 0;
+
+    adv->dict = NULL;
+    adv->entry = NULL;
+    adv->entry_left = 0;
+    adv->text_ret = 0;
+
+    adv->acc = 0;
+    adv->sp = 0;
+    for(i=0;i<PH_ADV_STACK_MAX;i++) adv->stack[i] = 0;
+    for(i=0;i<PH_VAR_MAX;i++) adv->vars[i] = 0;
+
+    /* Text that is laid out starts with the width of the screen */
+    adv->layout = 0;
+    if(data[0] == PH_CMD_LINE){
+        adv->layout = data[1];
+        adv->cur = 2;
+    }
+
+    /* Compressed data starts with the dictionary */
+    if(data[adv->cur] == PH_CMD_DICT){
+        adv->dict_count = _U16(data+adv->cur+1);
+        adv->dict = data+adv->cur+3;
+        adv->cur += 3+adv->dict_count*2;
+        if(adv->dict_count){
+            adv->cur += _U16(adv->dict+(adv->dict_count-1)*2);
+        }
+    }
 }
 
 #if 0 /* Debugging stuff */
@@ -67,350 +96,837 @@ static volatile char *const in_reg = (void*)(1024*1024+1);
 
 #define _VALID(c) ((c) < PH_CMD_START || (c) >= PH_CMD_END)
 
-#define _ALIGN() \
-    { \
-        putc('\n'); \
-        if(current_valign == PH_CMD_ALIGN_CENTER){ \
-            size_t n; \
- \
-            for(n=0;n<(h-1-lines)/2;n++){ \
-                putc('\n'); \
-            } \
-        } \
+/* Chars of the text that are neither a dictionary code nor the end of a
+ * pooled string */
+#define _PLAIN(adv, c) \
+    ((c) && (c) < PH_CMD_START && !((adv)->dict && PH_DICT_IS_CODE(c)))
+
+/* Reads the byte of the text at cur, most of the text isn't pooled so
+ * text_pool is only called inside of the pool, at a reference to it or at a
+ * line record */
+#define _TEXT_BYTE(adv, text) \
+    ((text)->ret || \
+     (unsigned int)((adv)->data[(text)->cur]-PH_CMD_TEXTREF) < 2 ? \
+     text_pool(adv, text) : (adv)->data[(text)->cur])
+
+/* Reads an offset to a label or a pooled string at *p, that is relative to
+ * its end, and moves *p to its end */
+static size_t get_offset(unsigned char **p) {
+    unsigned char *code = *p;
+    size_t size = PH_OFFSET_SIZE(*code);
+    size_t offset = 0;
+    size_t i;
+
+    for(i=0;i<size;i++){
+        offset |= (size_t)code[i]<<(i*8);
     }
+    *p = code+size;
+
+    /* Sign extend the offset */
+    offset >>= 2;
+    if(offset&((size_t)1<<(size*8-3))) offset -= (size_t)1<<(size*8-2);
+
+    return offset;
+}
+
+#define _OPS(name, fnc, id, ops) ops,
+
+/* Layout of the operands of each command */
+static const unsigned char ops[] = {PH_CMD_TABLE(_OPS)};
 
-#define _CLEAR() \
-    { \
-        for(i=0;i<h;i++){ \
-            putc('\n'); \
-        } \
-        set_cur_x(0); \
-        set_cur_y(0); \
-        lines = 0; \
-        current_valign = valign; \
-        if(current_valign != PH_CMD_ALIGN_TOP) set_cur_y(h); \
+/* Returns the size of the command at code with all its operands, to skip
+ * it */
+static size_t cmd_size(unsigned char *code) {
+    unsigned char op = ops[*code-PH_CMD_START];
+    size_t n = 1+PH_OPS_BYTES(op);
+
+    if((op&PH_OPS_VAR) && code[1] == PH_CMD_VAR_SET) n += 4;
+
+    if(op&PH_OPS_STR){
+        if(code[n] == PH_CMD_TEXTREF){
+            n++;
+            n += PH_OFFSET_SIZE(code[n]);
+        }else{
+            while(code[n]) n++;
+            n++;
+        }
     }
 
-#define _PAGEBREAK() \
-    { \
-        size_t n; \
- \
-        _ALIGN(); \
-        set_cur_x(0); \
-        set_cur_y(h-1); \
-        for(n=0;n<w;n++) putc(' '); \
-        set_cur_x(0); \
-        puts("Continue..."); \
-        while(*in_reg); \
-        while(!(*in_reg)); \
-        _CLEAR(); \
+    if(op&PH_OPS_LABEL) n += PH_OFFSET_SIZE(code[n]);
+
+    return n;
+}
+
+/* Position in the text, inside of a dictionary entry if left isn't 0, and
+ * number of chars read. ret is where to go back to at the end of a pooled
+ * string, 0 outside of the pool. */
+typedef struct {
+    size_t cur;
+    unsigned char *entry;
+    size_t left;
+    size_t ret;
+    size_t count;
+} PHTextPos;
+
+/* Enters the pooled string at cur, or goes back to the text that uses it at
+ * its end, and returns the byte at cur. The line records are skipped if the
+ * text is laid out at run time. */
+static unsigned char text_pool(PHAdventure *adv, PHTextPos *text) {
+    unsigned char *p;
+    size_t offset;
+    unsigned char c;
+
+    while(1){
+        c = adv->data[text->cur];
+
+        if(text->ret){
+            if(c) return c;
+
+            text->cur = text->ret;
+            text->ret = 0;
+        }else if(c == PH_CMD_TEXTREF){
+            p = adv->data+text->cur+1;
+            offset = get_offset(&p);
+            text->ret = p-adv->data;
+            text->cur = text->ret+offset;
+        }else if(c == PH_CMD_LINE && !adv->layout){
+            text->cur += 2;
+        }else{
+            return c;
+        }
     }
+}
 
-void ph_adventure_run(PHAdventure *adv) {
-    size_t target;
-    size_t start;
+/* Returns the entry i of the dictionary and puts its length in len */
+static unsigned char *get_entry(PHAdventure *adv, size_t i, size_t *len) {
+    size_t start = i ? _U16(adv->dict+(i-1)*2) : 0;
+
+    *len = _U16(adv->dict+i*2)-start;
+
+    return adv->dict+adv->dict_count*2+start;
+}
+
+/* Returns the next char of the text, or -1 if the next byte is a command */
+static int text_peek(PHAdventure *adv, PHTextPos *text) {
     unsigned char c;
+    size_t len;
 
-    static unsigned char buffer[PH_ADV_CASE_LEN_MAX];
+    if(text->left) return *text->entry;
+
+    c = _TEXT_BYTE(adv, text);
+    if(adv->dict){
+        if(PH_DICT_IS_CODE(c)){
+            return *get_entry(adv, PH_DICT_INDEX(c), &len);
+        }else if(c == PH_CMD_DICT){
+            return *get_entry(adv, PH_DICT_SHORT+adv->data[text->cur+1],
+                              &len);
+        }
+    }
 
-    unsigned short int lines = 0;
+    return _VALID(c) ? c : -1;
+}
 
-    unsigned char halign = PH_CMD_ALIGN_LEFT;
-    unsigned char valign = PH_CMD_ALIGN_TOP;
+static void text_next(PHAdventure *adv, PHTextPos *text) {
+    unsigned char c;
 
-    unsigned char current_valign = valign;
+    text->count++;
 
-    unsigned char note;
+    if(text->left){
+        text->entry++;
+        text->left--;
+        return;
+    }
 
-    unsigned char loading_bgm = 0;
+    c = _TEXT_BYTE(adv, text);
+    if(adv->dict && PH_DICT_IS_CODE(c)){
+        text->entry = get_entry(adv, PH_DICT_INDEX(c), &text->left);
+        text->cur++;
+    }else if(adv->dict && c == PH_CMD_DICT){
+        text->entry = get_entry(adv, PH_DICT_SHORT+adv->data[text->cur+1],
+                                &text->left);
+        text->cur += 2;
+    }else{
+        text->cur++;
+        return;
+    }
 
-    unsigned short int w, h;
+    /* The first char of the entry has been read */
+    text->entry++;
+    text->left--;
+}
 
-    unsigned char verbatim = 0;
+#define _FILL_SIZE 16
 
-    unsigned short int x;
+static char newlines[_FILL_SIZE+1] = "\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n\n";
+static char spaces[_FILL_SIZE+1] = "                ";
+
+/* Prints n times the char fill is made of */
+static void put_fill(char *fill, size_t n) {
+    while(n > _FILL_SIZE){
+        putn(fill, _FILL_SIZE);
+        n -= _FILL_SIZE;
+    }
+    putn(fill, n);
+}
+
+static void align(PHAdventure *adv) {
+    putc('\n');
+    if(adv->current_valign == PH_CMD_ALIGN_CENTER){
+        put_fill(newlines, (adv->h-1-adv->lines)/2);
+    }
+}
+
+static void clear(PHAdventure *adv) {
+    put_fill(newlines, adv->h);
+    set_cur_x(0);
+    set_cur_y(0);
+    adv->lines = 0;
+    adv->current_valign = adv->valign;
+    if(adv->current_valign != PH_CMD_ALIGN_TOP) set_cur_y(adv->h);
+}
+
+static void pagebreak(PHAdventure *adv) {
+    align(adv);
+    set_cur_x(0);
+    set_cur_y(adv->h-1);
+    put_fill(spaces, adv->w);
+    set_cur_x(0);
+    puts("Continue...");
+    while(*in_reg);
+    while(!(*in_reg));
+    clear(adv);
+}
+
+/* NOTE: Each command is run by a handler that gets the address of its opcode
+ * and returns the address of the next command. The handlers are indexed by
+ * the opcode minus PH_CMD_START, all the bytes that aren't a command are
+ * text. */
+
+typedef unsigned char *(*PHHandler)(PHAdventure *adv, unsigned char *pc);
 
-    unsigned char valid = 1;
+static unsigned char *cmd_startverbatim(PHAdventure *adv, unsigned char *pc) {
+    adv->verbatim = 1;
+    adv->lines = get_cur_y();
 
+    return pc+1;
+}
+
+static unsigned char *cmd_endverbatim(PHAdventure *adv, unsigned char *pc) {
+    adv->verbatim = 0;
+
+    return pc+1;
+}
+
+static unsigned char *cmd_clear(PHAdventure *adv, unsigned char *pc) {
+    clear(adv);
+
+    return pc+1;
+}
+
+static unsigned char *cmd_halign(PHAdventure *adv, unsigned char *pc) {
+    adv->halign = pc[1]&3;
+
+    return pc+2;
+}
+
+static unsigned char *cmd_valign(PHAdventure *adv, unsigned char *pc) {
+    adv->valign = pc[1]&3;
+
+    return pc+2;
+}
+
+static unsigned char *cmd_setx(PHAdventure *adv, unsigned char *pc) {
+    (void)adv;
+    set_cur_x(_U16(pc+1));
+
+    return pc+3;
+}
+
+static unsigned char *cmd_sety(PHAdventure *adv, unsigned char *pc) {
+    (void)adv;
+    set_cur_y(_U16(pc+1));
+
+    return pc+3;
+}
+
+static unsigned char *cmd_pagebreak(PHAdventure *adv, unsigned char *pc) {
+    pagebreak(adv);
+
+    return pc+1;
+}
+
+static unsigned char *cmd_label(PHAdventure *adv, unsigned char *pc) {
+    /* NOTE: This command shouldn't occur in normal conditions */
+    (void)adv;
+
+    return pc+1;
+}
+
+static unsigned char *cmd_goto_cmd(PHAdventure *adv, unsigned char *pc) {
+    size_t offset;
+
+    (void)adv;
+    pc++;
+    offset = get_offset(&pc);
+
+    /* The offset is relative to the end of the goto */
+    return pc+offset;
+}
+
+/* Skips a command that isn't implemented */
+static unsigned char *cmd_skip(PHAdventure *adv, unsigned char *pc) {
+    (void)adv;
+
+    return pc+cmd_size(pc);
+}
+
+/* Returns the bitmap of the dcases of a case table, that comes after its
+ * slots, and the cases that follow it */
+#define _CASE_SHOWN(table) ((table)+4+((size_t)2<<(table)[3]))
+#define _CASE_ENTRIES(table) (_CASE_SHOWN(table)+(_U16((table)+1)+7)/8)
+
+/* A run of cases, put in a table by datagen. The dcases are printed in the
+ * order of the source. */
+static unsigned char *cmd_cases(PHAdventure *adv, unsigned char *pc) {
+    size_t count = _U16(pc+1);
+    unsigned char *shown = _CASE_SHOWN(pc);
+    unsigned char *entries = _CASE_ENTRIES(pc);
+    unsigned char *p;
+    size_t offset;
     size_t i;
 
-    term_size(&w, &h);
+    if(adv->case_count < PH_ADV_CASE_MAX){
+        adv->case_tables[adv->case_count++] = pc;
 
-    while(1){
-        switch((c = _C)){
-            case PH_CMD_STARTVERBATIM:
-                verbatim = 1;
-                adv->cur++;
-                lines = get_cur_y();
-                break;
-
-            case PH_CMD_ENDVERBATIM:
-                verbatim = 0;
-                adv->cur++;
-                break;
-
-            case PH_CMD_CLEAR:
-                _CLEAR();
-                adv->cur++;
-                break;
-
-            case PH_CMD_HALIGN:
-                adv->cur++;
-                halign = _C&3;
-                adv->cur++;
-                break;
-
-            case PH_CMD_VALIGN:
-                adv->cur++;
-                valign = _C&3;
-                adv->cur++;
-                break;
-
-            case PH_CMD_SETX:
-                adv->cur++;
-                target = _C;
-                adv->cur++;
-                target |= _C<<8;
-                adv->cur++;
-                set_cur_x(target);
-                break;
-
-            case PH_CMD_SETY:
-                adv->cur++;
-                target = _C;
-                adv->cur++;
-                target |= _C<<8;
-                adv->cur++;
-                set_cur_x(target);
-                break;
-
-            case PH_CMD_PAGEBREAK:
-                _PAGEBREAK();
-                adv->cur++;
-                break;
-
-            case PH_CMD_LABEL:
-                /* NOTE: This command shouldn't occur in normal conditions */
-                break;
-
-            case PH_CMD_GOTO:
-                adv->cur++;
-                target = _C;
-                adv->cur++;
-                target |= _C<<8;
-                adv->cur++;
-                target |= _C<<16;
-                adv->cur++;
-                target |= _C<<24;
-                adv->cur++;
-                /* FIXME: Why do I have such a weird behaviour depending on the
-                 * sign. */
-                adv->cur += target+(target&0x80000000 ? 1 : 0);
-                break;
-
-            case PH_CMD_DCASE:
-            case PH_CMD_CASE:
-                if(adv->case_count < PH_ADV_CASE_MAX){
-                    size_t n;
-
-                    adv->cur++;
-                    for(n=0;_C;n++){
-                        adv->case_buffer[adv->case_count].name[n] = _C;
-                        adv->cur++;
-                    }
-                    adv->case_buffer[adv->case_count].name[n] = 0;
-                    adv->cur++;
-
-                    target = _C;
-                    adv->cur++;
-                    target |= _C<<8;
-                    adv->cur++;
-                    target |= _C<<16;
-                    adv->cur++;
-                    target |= _C<<24;
-                    adv->cur++;
-
-                    target = adv->cur+target+1;
-
-                    adv->case_buffer[adv->case_count].offset = target;
-                    if(c == PH_CMD_DCASE){
-                        puts("command: ");
-                        puts((char*)adv->case_buffer[adv->case_count].name);
-                        putc('\n');
-                    }
+        for(i=0;i<count;i++){
+            if(!(shown[i>>3]&(1<<(i&7)))) continue;
 
-                    adv->case_count++;
-                }
-                break;
-
-            case PH_CMD_CLEARCASES:
-                adv->case_count = 0;
-                break;
-
-            case PH_CMD_ASK:
-            case PH_CMD_ASKC:
-                if(valid) _ALIGN();
-
-                if(get_cur_x()) putc('\n');
-                set_cur_y(h-1);
-                puts(" > ");
-                gets((char*)buffer, PH_ADV_CASE_LEN_MAX);
-
-                {
-                    size_t n;
-                    for(n=0;n<adv->case_count;n++){
-                        if(!strcmp((char*)adv->case_buffer[n].name,
-                                   (char*)buffer)){
-                            target = adv->case_buffer[n].offset;
-                            adv->cur = target;
-                            break;
-                        }
-                    }
-                    if(n == adv->case_count){
-                        valid = 0;
-                        set_cur_y(h-1);
-                        set_cur_x(0);
-                        for(i=0;i<w;i++) putc(' ');
-                        set_cur_x(w-1-sizeof("(Invalid input)"));
-                        puts("(Invalid input)");
-                        set_cur_x(0);
+            p = entries+i*PH_CASES_ENTRY_SIZE;
+            offset = get_offset(&p);
+
+            puts("command: ");
+            puts((char*)p+offset);
+            putc('\n');
+        }
+    }
+
+    return entries+count*PH_CASES_ENTRY_SIZE;
+}
+
+/* Returns the label of the case of a table named name, or NULL if there is
+ * none. hash is the hash of the name. */
+static unsigned char *case_find(unsigned char *table, char *name,
+                                size_t hash) {
+    unsigned char *entries = _CASE_ENTRIES(table);
+    unsigned char *p;
+    size_t mask = ((size_t)1<<table[3])-1;
+    size_t offset;
+    size_t n;
+
+    for(hash&=mask;;hash=(hash+1)&mask){
+        n = _U16(table+4+hash*2);
+        if(!n) return NULL;
+
+        p = entries+(n-1)*PH_CASES_ENTRY_SIZE;
+        offset = get_offset(&p);
+        if(!strcmp((char*)p+offset, name)){
+            offset = get_offset(&p);
+            return p+offset;
+        }
+    }
+}
+
+static unsigned char *cmd_clearcases(PHAdventure *adv, unsigned char *pc) {
+    adv->case_count = 0;
+
+    return pc+1;
+}
+
+static unsigned char *cmd_ask(PHAdventure *adv, unsigned char *pc) {
+    static unsigned char buffer[PH_ADV_CASE_LEN_MAX];
+
+    unsigned char *label = NULL;
+    size_t hash = PH_CASE_HASH_INIT;
+    size_t n;
+
+    if(adv->valid) align(adv);
+
+    if(get_cur_x()) putc('\n');
+    set_cur_y(adv->h-1);
+    puts(" > ");
+    gets((char*)buffer, PH_ADV_CASE_LEN_MAX);
+
+    for(n=0;buffer[n];n++) hash = PH_CASE_HASH(hash, buffer[n]);
+    for(n=0;n<adv->case_count && label == NULL;n++){
+        label = case_find(adv->case_tables[n], (char*)buffer, hash);
+    }
+    if(label == NULL){
+        /* Ask again */
+        adv->valid = 0;
+        set_cur_y(adv->h-1);
+        set_cur_x(0);
+        put_fill(spaces, adv->w);
+        set_cur_x(adv->w-1-sizeof("(Invalid input)"));
+        puts("(Invalid input)");
+        set_cur_x(0);
+
+        return pc;
+    }
+
+    adv->valid = 1;
+    clear(adv);
+
+    if(*pc == PH_CMD_ASKC) adv->case_count = 0;
+
+    return label;
+}
+
+static unsigned char *cmd_delay(PHAdventure *adv, unsigned char *pc) {
+    size_t delay = _U16(pc+1);
+    size_t start;
+
+    (void)adv;
+    start = mstime();
+    while(mstime()-start < delay){
+        /* Run the sound engine */
+    }
+
+    return pc+3;
+}
+
+static unsigned char *cmd_note(PHAdventure *adv, unsigned char *pc) {
+    if(adv->loading_bgm){
+        /* TODO */
+    }else{
+        beep(pc[1], _U16(pc+2));
+    }
+
+    return pc+4;
+}
+
+static unsigned char *cmd_startbgm(PHAdventure *adv, unsigned char *pc) {
+    adv->loading_bgm = 1;
+
+    return pc+1;
+}
+
+static unsigned char *cmd_endbgm(PHAdventure *adv, unsigned char *pc) {
+    adv->loading_bgm = 0;
+
+    return pc+1;
+}
+
+/* Prints a line of width chars from text, aligned with halign */
+static void put_line(PHAdventure *adv, PHTextPos *text, size_t width) {
+    unsigned short int x;
+    unsigned char *p;
+    size_t i, n;
+    int ch;
+
+    if(adv->halign == PH_CMD_ALIGN_LEFT){
+        x = 0;
+    }else if(adv->halign == PH_CMD_ALIGN_CENTER){
+        x = (adv->w-1-width)/2;
+    }else{
+        x = adv->w-1-width;
+    }
+
+    set_cur_x(x);
+    for(i=0;i<width;i+=n){
+        /* Print the chars that are stored as is in a single transfer, either
+         * from a dictionary entry or from the data */
+        if(text->left){
+            p = text->entry;
+            for(n=0;n<text->left && i+n<width;n++){
+                if(p[n] == '\n') adv->lines++;
+            }
+            text->entry += n;
+            text->left -= n;
+        }else{
+            p = adv->data+text->cur;
+            for(n=0;i+n<width && _PLAIN(adv, p[n]);n++){
+                if(p[n] == '\n') adv->lines++;
+            }
+            text->cur += n;
+        }
+        if(n){
+            putn((char*)p, n);
+            text->count += n;
+            continue;
+        }
+
+        /* Enter or leave a pooled string, or expand a dictionary code */
+        ch = text_peek(adv, text);
+        putc(ch);
+        if(ch == '\n'){
+            adv->lines++;
+        }
+        text_next(adv, text);
+        n = 1;
+    }
+    if(adv->lines < adv->h-1){
+        putc('\n');
+        adv->lines++;
+    }
+    if(adv->lines >= adv->h-1) pagebreak(adv);
+}
+
+/* Text, a dictionary entry of compressed text or a pooled string */
+static unsigned char *cmd_text(PHAdventure *adv, unsigned char *pc) {
+    PHTextPos text, start_pos, saved;
+    unsigned short int w = adv->w;
+    size_t width;
+    size_t i;
+    int ch;
+
+    /* TODO: Add word wrap etc. */
+    text.cur = pc-adv->data;
+    text.entry = adv->entry;
+    text.left = adv->entry_left;
+    text.ret = adv->text_ret;
+    text.count = 0;
+
+    if(text_peek(adv, &text) >= 0){
+        if(adv->verbatim){
+            putc(text_peek(adv, &text));
+            text_next(adv, &text);
+        }else{
+            /* Wrap */
+
+            start_pos = text;
+            for(i=0;i<w && text_peek(adv, &text) >= 0x20;){
+                size_t n;
+
+                /* Check if text up to the next boundary can fit on this
+                 * line. */
+
+                saved = text;
+                for(n=i;;n++,text_next(adv, &text)){
+                    if(n >= w){
+                        text = saved;
                         break;
-                    }else{
-                        valid = 1;
-                        _CLEAR();
                     }
+                    ch = text_peek(adv, &text);
+                    if(ch == ' ' || ch == '\t' || ch == '\n' ||
+                       ch < 0) break;
                 }
-                if(c == PH_CMD_ASKC) adv->case_count = 0;
-                break;
-
-            case PH_CMD_DELAY:
-                adv->cur++;
-                target = _C;
-                adv->cur++;
-                target |= _C<<8;
-                adv->cur++;
-                start = mstime();
-                while(mstime()-start < target){
-                    /* Run the sound engine */
-                }
-                break;
-
-            case PH_CMD_NOTE:
-                adv->cur++;
-                note = _C;
-                adv->cur++;
-                target = _C;
-                adv->cur++;
-                target |= _C<<8;
-                adv->cur++;
-                if(loading_bgm){
-                    /* TODO */
-                }else{
-                    beep(note, target);
-                }
-                break;
-
-            case PH_CMD_STARTBGM:
-                loading_bgm = 1;
-                break;
-
-            case PH_CMD_ENDBGM:
-                loading_bgm = 0;
-                break;
-
-            case PH_CMD_VAR:
-                /* TODO */
-                break;
-
-            case PH_CMD_MATH:
-                /* TODO */
-                break;
-
-            case PH_CMD_TMPOP:
-                /* TODO */
-                break;
-
-            case PH_CMD_BRANCH:
-                /* TODO */
-                break;
-
-            case PH_CMD_IOOP:
-                /* TODO */
-                break;
-
-            case PH_CMD_RETURN:
-                /* TODO */
-                break;
-
-            case PH_CMD_EXTENDED:
-                /* TODO */
-                break;
-
-            default:
-                /* TODO: Add word wrap etc. */
-                if(_VALID(_C)){
-                    if(verbatim){
-                        putc(_C);
-                        adv->cur++;
-                    }else{
-                        /* Wrap */
-
-                        start = adv->cur;
-                        for(i=0;i<w && _VALID(_C) && _C>=0x20;){
-                            size_t n;
-
-                            /* Check if text up to the next boundary can fit
-                             * on this line. */
-
-                            target = adv->cur;
-                            for(n=i;;n++,adv->cur++){
-                                if(n >= w){
-                                    adv->cur = target;
-                                    break;
-                                }
-                                if(_C == ' ' || _C == '\t' || _C == '\n' ||
-                                   !_VALID(_C)) break;
-                            }
-                            if(!_VALID(_C)) break;
-                            if(n < w){
-                                if(_C == '\n'){
-                                    adv->cur++;
-                                    break;
-                                }
-                                adv->cur++;
-                                n++;
-                            }
-                            i=n;
-                        }
-
-                        /* NOTE: target contains the width here */
-                        target = adv->cur-start;
-
-                        if(halign == PH_CMD_ALIGN_LEFT){
-                            x = 0;
-                        }else if(halign == PH_CMD_ALIGN_CENTER){
-                            x = (w-1-target)/2;
-                        }else if(halign == PH_CMD_ALIGN_RIGHT){
-                            x = w-1-target;
-                        }
-
-                        adv->cur = start;
-
-                        set_cur_x(x);
-                        for(i=0;i<target;i++){
-                            putc(_C);
-                            if(_C == '\n'){
-                                lines++;
-                            }
-                            adv->cur++;
-                        }
-                        if(lines < h-1){
-                            putc('\n');
-                            lines++;
-                        }
-                        if(lines >= h-1) _PAGEBREAK();
+                ch = text_peek(adv, &text);
+                if(ch < 0) break;
+                if(n < w){
+                    if(ch == '\n'){
+                        text_next(adv, &text);
+                        break;
                     }
+                    text_next(adv, &text);
+                    n++;
                 }
+                i=n;
+            }
+
+            width = text.count-start_pos.count;
+            text = start_pos;
+
+            put_line(adv, &text, width);
+        }
+    }
+
+    adv->entry = text.entry;
+    adv->entry_left = text.left;
+    adv->text_ret = text.ret;
+
+    return adv->data+text.cur;
+}
+
+/* A line laid out by datagen */
+static unsigned char *cmd_line(PHAdventure *adv, unsigned char *pc) {
+    PHTextPos text;
+
+    /* The text is printed as usual if the screen has another width */
+    if(!adv->layout || adv->verbatim) return pc+2;
+
+    text.cur = pc+2-adv->data;
+    text.entry = NULL;
+    text.left = 0;
+    text.ret = 0;
+    text.count = 0;
+
+    put_line(adv, &text, pc[1]);
+
+    adv->entry = text.entry;
+    adv->entry_left = text.left;
+    adv->text_ret = text.ret;
+
+    return adv->data+text.cur;
+}
+
+/* Pops a value from the stack of the arithmetic commands, or returns 0 if it
+ * is empty */
+static unsigned int pop(PHAdventure *adv) {
+    if(!adv->sp) return 0;
+
+    return adv->stack[--adv->sp];
+}
+
+static unsigned char *cmd_var(PHAdventure *adv, unsigned char *pc) {
+    unsigned int *var;
+
+    if(pc[1] == PH_CMD_VAR_SET){
+        adv->vars[pc[6]] = _U32(pc+2);
+
+        return pc+7;
+    }
+
+    /* The linker replaced the name of the variable by its slot */
+    var = adv->vars+pc[2];
+    switch(pc[1]){
+        case PH_CMD_VAR_LOAD:
+            adv->acc = *var;
+            break;
+        case PH_CMD_VAR_STORE:
+            *var = adv->acc;
+            break;
+        case PH_CMD_VAR_DEL:
+            *var = 0;
+            break;
+    }
+
+    return pc+3;
+}
+
+/* Signed division of a by b, or its remainder if mod is set. Dividing by 0
+ * gives 0. */
+static unsigned int divide(unsigned int a, unsigned int b,
+                           unsigned char mod) {
+    if(!b) return 0;
+    /* The smallest number divided by -1 doesn't fit */
+    if(b == (unsigned int)-1) return mod ? 0 : 0-a;
+
+    if(mod) return (unsigned int)((int)a%(int)b);
+
+    return (unsigned int)((int)a/(int)b);
+}
+
+static unsigned char *cmd_math(PHAdventure *adv, unsigned char *pc) {
+    unsigned int a = pop(adv);
+    unsigned int b = adv->acc;
+
+    switch(pc[1]){
+        case PH_CMD_MATH_ADD:
+            a += b;
+            break;
+        case PH_CMD_MATH_SUB:
+            a -= b;
+            break;
+        case PH_CMD_MATH_MUL:
+            a *= b;
+            break;
+        case PH_CMD_MATH_DIV:
+        case PH_CMD_MATH_MOD:
+            a = divide(a, b, pc[1] == PH_CMD_MATH_MOD);
+            break;
+        case PH_CMD_MATH_LSL:
+            a <<= b&31;
+            break;
+        case PH_CMD_MATH_LSR:
+            a >>= b&31;
+            break;
+        case PH_CMD_MATH_AND:
+            a &= b;
+            break;
+        case PH_CMD_MATH_OR:
+            a |= b;
+            break;
+        case PH_CMD_MATH_XOR:
+            a ^= b;
+            break;
+    }
+    adv->acc = a;
+
+    return pc+2;
+}
+
+static unsigned char *cmd_tmp(PHAdventure *adv, unsigned char *pc) {
+    switch(pc[1]){
+        case PH_CMD_TMP_PUSH:
+            /* The value is lost if the stack is full */
+            if(adv->sp < PH_ADV_STACK_MAX) adv->stack[adv->sp++] = adv->acc;
+            break;
+        case PH_CMD_TMP_PULL:
+            adv->acc = pop(adv);
+            break;
+        case PH_CMD_TMP_LOAD:
+            adv->acc = adv->sp ? adv->stack[adv->sp-1] : 0;
+            break;
+        case PH_CMD_TMP_USE:
+            if(adv->sp) adv->stack[adv->sp-1] = adv->acc;
+            break;
+        case PH_CMD_TMP_GET:
+            adv->acc = adv->acc < adv->sp ? adv->stack[adv->acc] : 0;
+            break;
+        case PH_CMD_TMP_SETSP:
+            adv->sp = adv->acc < PH_ADV_STACK_MAX ? adv->acc :
+                      PH_ADV_STACK_MAX;
+            break;
+        case PH_CMD_TMP_GETSP:
+            adv->acc = adv->sp;
+            break;
+    }
+
+    return pc+2;
+}
+
+static unsigned char *cmd_branch(PHAdventure *adv, unsigned char *pc) {
+    unsigned int a = pop(adv);
+    unsigned int b = adv->acc;
+    unsigned char jump = 0;
+    size_t offset;
+
+    switch(pc[1]){
+        case PH_CMD_BRANCH_EQ:
+            jump = a == b;
+            break;
+        case PH_CMD_BRANCH_NE:
+            jump = a != b;
+            break;
+        case PH_CMD_BRANCH_LT:
+            jump = (int)a < (int)b;
+            break;
+        case PH_CMD_BRANCH_LE:
+            jump = (int)a <= (int)b;
+            break;
+        case PH_CMD_BRANCH_GT:
+            jump = (int)a > (int)b;
+            break;
+        case PH_CMD_BRANCH_GE:
+            jump = (int)a >= (int)b;
+            break;
+        case PH_CMD_BRANCH_ULT:
+            jump = a < b;
+            break;
+        case PH_CMD_BRANCH_ULE:
+            jump = a <= b;
+            break;
+        case PH_CMD_BRANCH_UGT:
+            jump = a > b;
+            break;
+        case PH_CMD_BRANCH_UGE:
+            jump = a >= b;
+            break;
+    }
+
+    pc += 2;
+    offset = get_offset(&pc);
+
+    /* The offset is relative to the end of the branch */
+    return jump ? pc+offset : pc;
+}
+
+/* Reads a signed decimal number, the chars that aren't digits are
+ * ignored */
+static unsigned int input_int(void) {
+    static char buffer[12];
+
+    unsigned int n = 0;
+    size_t i;
+
+    gets(buffer, sizeof(buffer));
+
+    for(i=0;buffer[i];i++){
+        if(buffer[i] >= '0' && buffer[i] <= '9'){
+            /* n*10 without a multiplication */
+            n = (n<<3)+(n<<1)+(buffer[i]-'0');
+        }
+    }
+
+    return buffer[0] == '-' ? 0-n : n;
+}
+
+static unsigned char *cmd_io(PHAdventure *adv, unsigned char *pc) {
+    static char buffer[12];
+
+    switch(pc[1]){
+        case PH_CMD_IOOP_PUTINT:
+            itoa((int)adv->acc, buffer, sizeof(buffer));
+            puts(buffer);
+            break;
+        case PH_CMD_IOOP_PUTC:
+            putc(adv->acc);
+            break;
+        case PH_CMD_IOOP_INPUT:
+            adv->acc = input_int();
+            break;
+        case PH_CMD_IOOP_SETX:
+            set_cur_x(adv->acc);
+            break;
+        case PH_CMD_IOOP_SETY:
+            set_cur_y(adv->acc);
+            break;
+        case PH_CMD_IOOP_GETX:
+            adv->acc = get_cur_x();
+            break;
+        case PH_CMD_IOOP_GETY:
+            adv->acc = get_cur_y();
+            break;
+        case PH_CMD_IOOP_NOTE:
+            beep(pop(adv), adv->acc);
+            break;
+        case PH_CMD_IOOP_TIME:
+            adv->acc = mstime();
+            break;
+    }
+
+    return pc+2;
+}
+
+/* Ends the adventure */
+static unsigned char *cmd_return_cmd(PHAdventure *adv, unsigned char *pc) {
+    (void)adv;
+    (void)pc;
+
+    return NULL;
+}
+
+/* The variants of the commands, and the commands that aren't implemented */
+#define cmd_askc cmd_ask
+/* The linker puts all the cases in case tables */
+#define cmd_case_cmd cmd_skip
+#define cmd_dcase cmd_skip
+#define cmd_ext cmd_skip
+
+#define _HANDLER(name, fnc, id, ops) cmd_##fnc,
+
+static const PHHandler handlers[PH_CMD_END-PH_CMD_START] = {
+    PH_CMD_TABLE(_HANDLER)
+    /* PH_CMD_DICT and PH_CMD_TEXTREF */
+    cmd_text, cmd_text,
+    cmd_line,
+    cmd_cases
+};
+
+void ph_adventure_run(PHAdventure *adv) {
+    unsigned char *pc = adv->data+adv->cur;
+    unsigned char c;
+
+    adv->lines = 0;
+    adv->halign = PH_CMD_ALIGN_LEFT;
+    adv->valign = PH_CMD_ALIGN_TOP;
+    adv->current_valign = adv->valign;
+    adv->loading_bgm = 0;
+    adv->verbatim = 0;
+    adv->valid = 1;
+
+    term_size(&adv->w, &adv->h);
+    if(adv->layout != adv->w) adv->layout = 0;
+
+    /* The adventure ends at a return */
+    while(pc != NULL){
+        /* The rest of a dictionary entry or of a pooled string is text, like
+         * the bytes that aren't commands */
+        c = *pc-PH_CMD_START;
+        if(adv->entry_left || adv->text_ret || c >= PH_CMD_END-PH_CMD_START){
+            pc = cmd_text(adv, pc);
+        }else{
+            pc = handlers[c](adv, pc);
         }
     }
 }
@@ -38,19 +38,58 @@
 
 #include <stddef.h>
 
+#include <format.h>
+
+/* Number of case tables the next ask chooses from */
 #define PH_ADV_CASE_MAX 8
 #define PH_ADV_CASE_LEN_MAX 32
 
+/* Size of the stack of the arithmetic commands */
+#define PH_ADV_STACK_MAX 64
+
 typedef struct {
-    struct{
-        unsigned char name[PH_ADV_CASE_LEN_MAX];
-        size_t offset;
-    } case_buffer[PH_ADV_CASE_MAX];
+    /* Case tables in the data, each one holds a run of cases */
+    unsigned char *case_tables[PH_ADV_CASE_MAX];
     size_t case_count;
 
     unsigned char *data;
 
     size_t cur;
+
+    /* Dictionary of compressed text, NULL if the text isn't compressed */
+    unsigned char *dict;
+    size_t dict_count;
+
+    /* Rest of the dictionary entry being printed */
+    unsigned char *entry;
+    size_t entry_left;
+
+    /* Where to go back to at the end of the pooled string being printed */
+    size_t text_ret;
+
+    /* Width of the screen the text is laid out for, 0 if it is laid out at
+     * run time */
+    unsigned char layout;
+
+    /* Screen size and layout state of ph_adventure_run */
+    unsigned short int w, h;
+    unsigned short int lines;
+    unsigned char halign;
+    unsigned char valign;
+    unsigned char current_valign;
+
+    unsigned char verbatim;
+    unsigned char loading_bgm;
+
+    /* The last input matched a case */
+    unsigned char valid;
+
+    /* State of the arithmetic commands: the accumulator, the stack and the
+     * variables, indexed by the slots given by the linker */
+    unsigned int acc;
+    unsigned int stack[PH_ADV_STACK_MAX];
+    size_t sp;
+    unsigned int vars[PH_VAR_MAX];
 } PHAdventure;
 
 void ph_adventure_init(PHAdventure *adv, unsigned char *data);
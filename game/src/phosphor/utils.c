@@ -41,12 +41,26 @@ static volatile unsigned char *const audio_reg = (void*)(1024*1024+2);
 static volatile unsigned int *const time_reg = (void*)(1024*1024+4);
 static volatile unsigned short int *const xpos_reg = (void*)(1024*1024+8);
 static volatile unsigned short int *const ypos_reg = (void*)(1024*1024+10);
+/* Console DMA: the low 24 bits are the address of the text, the high byte is
+ * its length. Writing the high byte copies the text to the console. */
+static volatile unsigned int *const dma_reg = (void*)(1024*1024+12);
+
+#define PH_DMA_MAX 0xFF
 
 void puts(char *str) {
-    while(*str){
-        *out_reg = *str;
-        str++;
+    size_t len;
+
+    for(len=0;str[len];len++);
+    putn(str, len);
+}
+
+void putn(char *str, size_t len) {
+    while(len > PH_DMA_MAX){
+        *dma_reg = (unsigned int)(size_t)str|((unsigned int)PH_DMA_MAX<<24);
+        str += PH_DMA_MAX;
+        len -= PH_DMA_MAX;
     }
+    if(len) *dma_reg = (unsigned int)(size_t)str|((unsigned int)len<<24);
 }
 
 void putc(char c) {
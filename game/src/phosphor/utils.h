@@ -40,6 +40,8 @@
 
 void puts(char *str);
 void putc(char c);
+/* Prints the len chars at str through the console DMA */
+void putn(char *str, size_t len);
 void gets(char *str, size_t max);
 void beep(unsigned char note, size_t duration);
 
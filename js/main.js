@@ -60,6 +60,8 @@ function start() {
 
             var writeTmp;
 
+            var dmaAddr = 0;
+
             // Audio output
             const audioCtx = new AudioContext();
             const oscillator = audioCtx.createOscillator();
@@ -165,6 +167,31 @@ function start() {
                             termSetY(out, writeTmp|(byte<<8));
                             break;
 
+                        case 1024*1024+12:
+                            /* Console DMA address low byte */
+                            dmaAddr = byte;
+                            break;
+
+                        case 1024*1024+13:
+                            /* Console DMA address byte 1 */
+                            dmaAddr |= byte<<8;
+                            break;
+
+                        case 1024*1024+14:
+                            /* Console DMA address byte 2 */
+                            dmaAddr |= byte<<16;
+                            break;
+
+                        case 1024*1024+15:
+                            /* Console DMA length: copies the text from RAM
+                             * or ROM to the console at once */
+                            var str = "";
+                            for(var i=0;i<byte;i++){
+                                str += String.fromCharCode(r(rv, dmaAddr+i));
+                            }
+                            termPutS(out, str);
+                            break;
+
                         case 1024*1024+2:
                             /* Audio out */
                             /* Semitones:
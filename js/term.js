@@ -115,9 +115,7 @@ function termSetY(term, y) {
     __termAddCur(term);
 }
 
-function termPutC(term, char) {
-    __termRemoveCur(term);
-
+function __termPut(term, char) {
     const down = (term) => {
         term.y++;
         if(term.y >= term.h){
@@ -152,6 +150,48 @@ function termPutC(term, char) {
     if(term.x >= term.w){
         newLine(term);
     }
+}
+
+function termPutC(term, char) {
+    __termRemoveCur(term);
+    __termPut(term, char);
+    __termAddCur(term);
+}
+
+function termPutS(term, str) {
+    __termRemoveCur(term);
+
+    var i = 0;
+    while(i < str.length){
+        /* Write the chars that go on the current row at once */
+        var n = 0;
+        var text = "";
+        var pre = document.getElementById("terminal-row-" + term.y);
+        var row = pre.textContent;
+        while(i+n < str.length && term.x+n < term.w){
+            var c = str.charCodeAt(i+n);
+            if(c == 0x0A || c == 0x7F) break;
+            text += c == 0x11 ? row.charAt(term.x+n) : str[i+n];
+            n++;
+        }
+
+        if(n){
+            pre.textContent = row.substring(0, term.x) + text +
+                              row.substring(term.x+n);
+            term.x += n;
+            if(term.x >= term.w){
+                term.y++;
+                if(term.y >= term.h){
+                    termScroll(term);
+                }
+                term.x = 0;
+            }
+            i += n;
+        }else{
+            __termPut(term, str[i]);
+            i++;
+        }
+    }
 
     __termAddCur(term);
 }
@@ -0,0 +1,149 @@
+/* Phosphor Engine: A small but quite special game engine to create text
+ *                  adventures.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2025 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PHOSPHOR_COMMANDTABLE_H
+#define PHOSPHOR_COMMANDTABLE_H
+
+/* The commands, in the order of their opcodes starting at PH_CMD_START. Each
+ * entry is the name of the command in the text, the function of datagen that
+ * converts it, the name of its PH_CMD_* constant and the layout of its
+ * operands. The enumerations of format.h, the converter, the operand skipping
+ * of datagen and the operand table of the engine are all generated from
+ * these lists. */
+
+/* Layout of the operands of a command: a number of fixed bytes after the
+ * opcode, optionally followed by a NUL-terminated string and by an offset to
+ * a label. The label offsets aren't part of the commands in the object files,
+ * the linker inserts them. */
+#define PH_OPS_BYTES(ops) ((ops)&0x0F)
+/* A string follows the fixed bytes */
+#define PH_OPS_STR 0x10
+/* An offset to a label ends the command */
+#define PH_OPS_LABEL 0x20
+/* A 32 bit value follows the subcommand of var set */
+#define PH_OPS_VAR 0x40
+
+#define PH_CMD_TABLE(_X) \
+    _X("startverbatim", startverbatim, STARTVERBATIM, 0) \
+    _X("endverbatim", endverbatim, ENDVERBATIM, 0) \
+    _X("clear", clear, CLEAR, 0) \
+    _X("halign", halign, HALIGN, 1) \
+    _X("valign", valign, VALIGN, 1) \
+    _X("setx", setx, SETX, 2) \
+    _X("sety", sety, SETY, 2) \
+    _X("pagebreak", pagebreak, PAGEBREAK, 0) \
+    _X("label", label, LABEL, 0) \
+    _X("goto", goto_cmd, GOTO, PH_OPS_LABEL) \
+    _X("case", case_cmd, CASE, PH_OPS_STR|PH_OPS_LABEL) \
+    /* Displayed case */ \
+    _X("dcase", dcase, DCASE, PH_OPS_STR|PH_OPS_LABEL) \
+    /* Clear the case list */ \
+    _X("clearcases", clearcases, CLEARCASES, 0) \
+    _X("ask", ask, ASK, 0) \
+    /* Ask and clear case list */ \
+    _X("askc", askc, ASKC, 0) \
+    _X("delay", delay, DELAY, 2) \
+    _X("note", note, NOTE, 3) \
+    /* Start background music */ \
+    _X("startbgm", startbgm, STARTBGM, 0) \
+    /* End background music */ \
+    _X("endbgm", endbgm, ENDBGM, 0) \
+ \
+    /* Arithmetic commands */ \
+    _X("var", var, VAR, 1|PH_OPS_STR|PH_OPS_VAR) \
+    _X("math", math, MATH, 1) \
+    _X("tmp", tmp, TMPOP, 1) \
+    _X("branch", branch, BRANCH, 1|PH_OPS_LABEL) \
+    _X("io", io, IOOP, 1) \
+ \
+    _X("return", return_cmd, RETURN, 0) \
+ \
+    _X("ext", ext, EXTENDED, 1)
+
+/* The subcommands, with the name of their PH_CMD_<COMMAND>_* constant */
+
+#define PH_VAR_SUBCMDS(_X) \
+    _X("set", SET) \
+    _X("load", LOAD) \
+    _X("store", STORE) \
+    _X("del", DEL)
+
+#define PH_MATH_SUBCMDS(_X) \
+    _X("add", ADD) \
+    _X("sub", SUB) \
+    _X("mul", MUL) \
+    _X("div", DIV) \
+    _X("mod", MOD) \
+    _X("lsl", LSL) \
+    _X("lsr", LSR) \
+    _X("and", AND) \
+    _X("or", OR) \
+    _X("xor", XOR)
+
+#define PH_TMP_SUBCMDS(_X) \
+    _X("push", PUSH) \
+    _X("pull", PULL) \
+    _X("load", LOAD) \
+    _X("use", USE) \
+    _X("get", GET) \
+    _X("setsp", SETSP) \
+    _X("getsp", GETSP)
+
+#define PH_BRANCH_SUBCMDS(_X) \
+    _X("eq", EQ) \
+    _X("ne", NE) \
+    _X("lt", LT) \
+    _X("le", LE) \
+    _X("gt", GT) \
+    _X("ge", GE) \
+    _X("ult", ULT) \
+    _X("ule", ULE) \
+    _X("ugt", UGT) \
+    _X("uge", UGE)
+
+#define PH_IO_SUBCMDS(_X) \
+    _X("putint", PUTINT) \
+    _X("putc", PUTC) \
+    _X("input", INPUT) \
+    _X("setx", SETX) \
+    _X("sety", SETY) \
+    _X("getx", GETX) \
+    _X("gety", GETY) \
+    _X("note", NOTE) \
+    _X("time", TIME)
+
+#define PH_EXT_SUBCMDS(_X) /* TODO */
+
+#endif
@@ -36,7 +36,9 @@
 #ifndef PHOSPHOR_FORMAT_H
 #define PHOSPHOR_FORMAT_H
 
-#define PH_CMD_VERSION 1
+#define PH_CMD_VERSION 8
+
+#include <commandtable.h>
 
 #define PH_CMD_START 0x80
 #define PH_CMD_AMOUNT (PH_CMD_END-PH_CMD_START-1)
@@ -44,103 +46,119 @@
 #define PH_CONV_TOKEN_MAX 32
 #define PH_CONV_CMD_MAX_TOKENS 8
 
-#define PH_LABELCMD_AMOUNT 4
+#define _PH_CMD(name, fnc, id, ops) PH_CMD_##id,
 
 enum {
-    PH_CMD_STARTVERBATIM = PH_CMD_START,
-    PH_CMD_ENDVERBATIM,
-    PH_CMD_CLEAR,
-    PH_CMD_HALIGN,
-    PH_CMD_VALIGN,
-    PH_CMD_SETX,
-    PH_CMD_SETY,
-    PH_CMD_PAGEBREAK,
-    PH_CMD_LABEL,
-    PH_CMD_GOTO,
-    PH_CMD_CASE,
-    PH_CMD_DCASE,
-    PH_CMD_CLEARCASES,
-    PH_CMD_ASK,
-    PH_CMD_ASKC,
-    PH_CMD_DELAY,
-    PH_CMD_NOTE,
-    PH_CMD_STARTBGM,
-    PH_CMD_ENDBGM,
-
-    PH_CMD_VAR,
-    PH_CMD_MATH,
-    PH_CMD_TMPOP,
-    PH_CMD_BRANCH,
-    PH_CMD_IOOP,
-
-    PH_CMD_RETURN,
-
-    PH_CMD_EXTENDED,
+    /* The first command is PH_CMD_START */
+    PH_CMD_NONE = PH_CMD_START-1,
 
-    PH_CMD_END
-};
+    PH_CMD_TABLE(_PH_CMD)
 
-enum {
-    PH_CMD_ALIGN_LEFT   = 0,
-    PH_CMD_ALIGN_TOP    = 0,
-    PH_CMD_ALIGN_CENTER = 1,
-    PH_CMD_ALIGN_RIGHT  = 2,
-    PH_CMD_ALIGN_BOTTOM = 2
-};
+    /* Reference to a dictionary entry in compressed text, or the dictionary
+     * itself at the start of the data */
+    PH_CMD_DICT,
 
-enum {
-    PH_CMD_VAR_SET,
-    PH_CMD_VAR_LOAD,
-    PH_CMD_VAR_STORE,
-    PH_CMD_VAR_DEL
-};
+    /* Text stored once in the string pool, or name of a case stored in it,
+     * followed by the offset to the string */
+    PH_CMD_TEXTREF,
 
-enum {
-    PH_CMD_MATH_ADD,
-    PH_CMD_MATH_SUB,
-    PH_CMD_MATH_MUL,
-    PH_CMD_MATH_DIV,
-    PH_CMD_MATH_MOD,
-    PH_CMD_MATH_LSL,
-    PH_CMD_MATH_LSR,
-    PH_CMD_MATH_AND,
-    PH_CMD_MATH_OR,
-    PH_CMD_MATH_XOR
-};
+    /* Line of text laid out by datagen, followed by its length, or width of
+     * the screen it is laid out for at the start of the data */
+    PH_CMD_LINE,
 
-enum {
-    PH_CMD_TMP_PUSH,
-    PH_CMD_TMP_PULL,
-    PH_CMD_TMP_LOAD,
-    PH_CMD_TMP_USE,
-    PH_CMD_TMP_GET,
-    PH_CMD_TMP_SETSP,
-    PH_CMD_TMP_GETSP
+    /* Table of the cases of a run of case and dcase commands, built by the
+     * linker */
+    PH_CMD_CASES,
+
+    PH_CMD_END
 };
 
+/* Compressed data starts with PH_CMD_DICT, the number of entries of the
+ * dictionary, the end of each entry in the entry data (all 16 bit little
+ * endian) and the entry data. The first PH_DICT_SHORT entries are referred to
+ * by a single byte that is never part of the text, the other ones by
+ * PH_CMD_DICT followed by their index minus PH_DICT_SHORT. */
+#define PH_DICT_SHORT 30
+#define PH_DICT_MAX (PH_DICT_SHORT+256)
+
+#define PH_DICT_IS_CODE(c) (((c) >= 0x01 && (c) <= 0x08) || \
+                            ((c) >= 0x0B && (c) <= 0x1F) || (c) == 0x7F)
+#define PH_DICT_INDEX(c) ((c) == 0x7F ? 29 : (c) <= 0x08 ? (c)-0x01 : (c)-0x03)
+#define PH_DICT_CODE(i) ((i) == 29 ? 0x7F : (i) < 8 ? (i)+0x01 : (i)+0x03)
+
+/* Text laid out for a screen width starts with PH_CMD_LINE and the width,
+ * before the dictionary. Each line then starts with PH_CMD_LINE and its
+ * length in chars, including the space or the newline that ends it. The
+ * lines are cut where the engine would wrap them, so it can ignore the line
+ * records on screens of another width. */
+#define PH_LINE_MAX 255
+
+/* A case table starts with PH_CMD_CASES, the number of cases (16 bit little
+ * endian) and the log2 of the number of slots of its hash table. The slots
+ * follow, each one is the index of a case plus one, or 0 if it is empty (16
+ * bit little endian). A name is in the first free slot from its hash, the
+ * table is at most half full. Then comes a bitmap of the cases that are
+ * displayed, and the cases in the order of the source. Each case is a 32 bit
+ * offset to its name in the pool followed by a 32 bit offset to its label. */
+#define PH_CASES_ENTRY_SIZE 8
+#define PH_CASES_BITS_MAX 15
+
+/* Hash of the case names, that only needs shifts and additions */
+#define PH_CASE_HASH_INIT 5381
+#define PH_CASE_HASH(h, c) ((((h)<<5)+(h)+(c))&0xFFFF)
+
+/* The offsets to the labels are relative to their end. The two low bits of
+ * their first byte give their size, and the other bits are a signed little
+ * endian number. */
 enum {
-    PH_CMD_BRANCH_EQ,
-    PH_CMD_BRANCH_NE,
-    PH_CMD_BRANCH_LT,
-    PH_CMD_BRANCH_LE,
-    PH_CMD_BRANCH_GT,
-    PH_CMD_BRANCH_GE,
-    PH_CMD_BRANCH_ULT,
-    PH_CMD_BRANCH_ULE,
-    PH_CMD_BRANCH_UGT,
-    PH_CMD_BRANCH_UGE
+    PH_OFFSET_8,
+    PH_OFFSET_16,
+    PH_OFFSET_32
 };
 
+#define PH_OFFSET_SIZE(c) (1<<((c)&3))
+
 enum {
-    PH_CMD_IOOP_PUTINT,
-    PH_CMD_IOOP_PUTC,
-    PH_CMD_IOOP_INPUT,
-    PH_CMD_IOOP_SETX,
-    PH_CMD_IOOP_SETY,
-    PH_CMD_IOOP_GETX,
-    PH_CMD_IOOP_GETY,
-    PH_CMD_IOOP_NOTE,
-    PH_CMD_IOOP_TIME
+    PH_CMD_ALIGN_LEFT   = 0,
+    PH_CMD_ALIGN_TOP    = 0,
+    PH_CMD_ALIGN_CENTER = 1,
+    PH_CMD_ALIGN_RIGHT  = 2,
+    PH_CMD_ALIGN_BOTTOM = 2
 };
 
+/* The arithmetic commands work on a 32 bit accumulator, a stack of 32 bit
+ * values and variables. The linker gives each variable name a slot, and
+ * replaces the name that ends a var command by its slot (1 byte), so linked
+ * var commands are the opcode, the subcommand, the value of set (32 bit
+ * little endian) and the slot.
+ *
+ *  var set/load/store/del: variable = value/A = variable/variable = A/
+ *                          variable = 0
+ *  math:                   A = popped value <op> A, signed division, a
+ *                          division by 0 gives 0
+ *  tmp push/pull/load:     push A/pop A/A = top of the stack
+ *  tmp use/get:            top of the stack = A/A = value A of the stack
+ *  tmp setsp/getsp:        stack size = A/A = stack size
+ *  branch:                 jump to the label if popped value <cc> A, the
+ *                          u conditions are unsigned
+ *  io:                     putint, putc, setx and sety use A, input, getx,
+ *                          gety and time set it, note plays the popped
+ *                          note for A ms
+ *
+ * Pushing to a full stack does nothing, and popping from an empty one or
+ * reading past its top gives 0. */
+#define PH_VAR_MAX 256
+
+#define _PH_CMD_VAR(name, id) PH_CMD_VAR_##id,
+#define _PH_CMD_MATH(name, id) PH_CMD_MATH_##id,
+#define _PH_CMD_TMP(name, id) PH_CMD_TMP_##id,
+#define _PH_CMD_BRANCH(name, id) PH_CMD_BRANCH_##id,
+#define _PH_CMD_IOOP(name, id) PH_CMD_IOOP_##id,
+
+enum {PH_VAR_SUBCMDS(_PH_CMD_VAR) PH_CMD_VAR_AMOUNT};
+enum {PH_MATH_SUBCMDS(_PH_CMD_MATH) PH_CMD_MATH_AMOUNT};
+enum {PH_TMP_SUBCMDS(_PH_CMD_TMP) PH_CMD_TMP_AMOUNT};
+enum {PH_BRANCH_SUBCMDS(_PH_CMD_BRANCH) PH_CMD_BRANCH_AMOUNT};
+enum {PH_IO_SUBCMDS(_PH_CMD_IOOP) PH_CMD_IOOP_AMOUNT};
+
 #endif
@@ -36,9 +36,13 @@
 # POSSIBILITY OF SUCH DAMAGE.
 
 textdir=.
-data=../game/src/data/data.bin
+data=../game/src/data/data.o
+cache=../game/src/data/cache
 datagen=../datagen/main
 dataname=ph_data
+# Width the engine wraps the text at on the 80 column terminal of js/main.js:
+# term_size() reads it from the cursor, that stops on the last column
+width=79
 
 rootdir=$(dirname $0)
 orgdir=$(pwd)
@@ -57,24 +61,15 @@ errorcheck() {
 
 mkdir -p $(dirname $data)
 
-objlist=()
+srclist=()
 
 for i in $(find $textdir -type f ! -name "build.sh"); do
-    obj=$(dirname $data)/${i#$textdir}.obj
-
-    echo "-- Converting text adventure data $i to $obj..."
-    $datagen -c $i -o $obj
-
-    errorcheck
-
-    objlist+=($obj)
+    srclist+=($i)
 done
 
-echo "-- Linking text adventure data..."
-$datagen -l ${objlist[@]} -o $data
-errorcheck
-
-xxd -n $dataname -i $data > $data.c
+echo "-- Converting and linking text adventure data to $data..."
+$datagen -j 0 -C $cache --compress --layout $width --elf $dataname \
+    ${srclist[@]} -o $data
 errorcheck
 
 echo "-- Exiting $rootdir..."